@@ -6,6 +6,37 @@
 #include <set>
 #include <memory>
 #include <string>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+#include <limits>
+#include <zlib.h>
+#include <dlfcn.h>
+#include <csignal>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+
+#include "operator_plugin.h"
 
 namespace fs = std::filesystem;
 
@@ -13,470 +44,5104 @@ bool fileExistsInFolder(const std::string &folderPath, const std::string &filena
     return fs::exists(fs::path(folderPath) / filename);
 }
 
-bool fileWithExtensionExists(const std::string &folderPath, const std::string &extension) {
-    for (const auto &entry : fs::recursive_directory_iterator(folderPath)) {
-        if (entry.is_regular_file() && entry.path().extension() == extension)
-            return true;
-    }
-    return false;
+// Process-wide counters and latency histograms, rendered in the Prometheus text format (--metrics=<path> for
+// the node_exporter textfile collector, GET /metrics on the cache server). Every metric is split into
+// cache-line-sized shards and each thread updates its own, so hashing workers and server connections never
+// contend on a counter; reading sums the shards.
+constexpr size_t metricShards = 16;
+
+size_t metricShard() {
+    static std::atomic<size_t> nextShard{0};
+    thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % metricShards;
+    return shard;
 }
 
-class LanguageHandler {
+class Counter {
 public:
-    virtual bool detect(const std::string &folderPath) = 0;
-    virtual std::set<std::string> extractDependencies(const std::string &folderPath) = 0;
-    virtual std::string generateDockerfile(const std::string &folderPath,
-                                             const std::set<std::string> &deps) = 0;
-    virtual std::string getName() const = 0;
-    virtual ~LanguageHandler() {}
+    void add(uint64_t n = 1) { cells[metricShard()].value.fetch_add(n, std::memory_order_relaxed); }
+    
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto &cell : cells)
+            total += cell.value.load(std::memory_order_relaxed);
+        return total;
+    }
+    
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{0};
+    };
+    Cell cells[metricShards];
 };
 
-class PythonHandler : public LanguageHandler {
+class Histogram {
 public:
-    std::string getName() const override { return "Python"; }
+    static constexpr size_t bucketCount = 10;
     
-    bool detect(const std::string &folderPath) override {
-        if (fileExistsInFolder(folderPath, "requirements.txt"))
-            return true;
-        if (fileWithExtensionExists(folderPath, ".py"))
-            return true;
-        return false;
+    void observe(double seconds) {
+        static const double bounds[bucketCount] = {0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 1, 5, 30};
+        Cell &cell = cells[metricShard()];
+        size_t bucket = std::lower_bound(bounds, bounds + bucketCount, seconds) - bounds;
+        cell.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        cell.micros.fetch_add(static_cast<uint64_t>(seconds * 1e6), std::memory_order_relaxed);
     }
     
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        std::set<std::string> deps;
-        std::regex importRegex("^\\s*(import|from)\\s+([a-zA-Z0-9_]+)");
-        for (const auto &entry : fs::recursive_directory_iterator(folderPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".py") {
-                std::ifstream file(entry.path());
-                std::string line;
-                while (std::getline(file, line)) {
-                    std::smatch match;
-                    if (std::regex_search(line, match, importRegex))
-                        deps.insert(match[2]);
-                }
-            }
+    void render(std::string &out, const std::string &name, const std::string &label) const {
+        static const char *const bounds[bucketCount + 1] = {"0.001", "0.005", "0.01", "0.025", "0.05", "0.1",
+                                                             "0.25", "1", "5", "30", "+Inf"};
+        uint64_t cumulative = 0, micros = 0;
+        for (size_t b = 0; b <= bucketCount; ++b) {
+            for (const auto &cell : cells)
+                cumulative += cell.buckets[b].load(std::memory_order_relaxed);
+            out += name + "_bucket{" + label + ",le=\"" + bounds[b] + "\"} " + std::to_string(cumulative) + "\n";
         }
-        return deps;
+        for (const auto &cell : cells)
+            micros += cell.micros.load(std::memory_order_relaxed);
+        char sum[32];
+        std::snprintf(sum, sizeof(sum), "%.6f", micros / 1e6);
+        out += name + "_sum{" + label + "} " + sum + "\n";
+        out += name + "_count{" + label + "} " + std::to_string(cumulative) + "\n";
     }
     
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM python:3.9\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        if (fileExistsInFolder(folderPath, "requirements.txt"))
-            docker += "RUN pip install --upgrade pip && pip install -r requirements.txt\n";
-        else if (!deps.empty()) {
-            docker += "RUN pip install --upgrade pip && pip install";
-            for (const auto &dep : deps)
-                docker += " " + dep;
-            docker += "\n";
-        }
-        docker += "CMD [\"python\", \"main.py\"]\n";
-        return docker;
-    }
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> buckets[bucketCount + 1] = {};
+        std::atomic<uint64_t> micros{0};
+    };
+    Cell cells[metricShards];
 };
 
-class NodeHandler : public LanguageHandler {
-public:
-    std::string getName() const override { return "Node.js"; }
+const char *const metricPhases[] = {"scan", "detect", "extract", "generate", "optimize", "write"};
+const char *const cacheServerMethods[] = {"GET", "HEAD", "PUT", "DELETE", "MKCOL", "PROPFIND", "other"};
+
+struct OperatorMetrics {
+    Counter projects;
+    Counter filesScanned;
+    Counter bytesRead;
+    Histogram phases[std::size(metricPhases)];
+    Counter fileHashHits;
+    Counter fileHashMisses;
+    Counter cacheServerRequests[std::size(cacheServerMethods)];
+    Counter compileCacheHits;
+    Counter compileCacheMisses;
+    Counter compileCacheStores;
+    Counter compileCacheStoredBytes;
     
-    bool detect(const std::string &folderPath) override {
-        if (fileExistsInFolder(folderPath, "package.json"))
-            return true;
-        if (fileWithExtensionExists(folderPath, ".js") || fileWithExtensionExists(folderPath, ".ts"))
-            return true;
-        return false;
+    void observePhase(const std::string &phase, double seconds) {
+        for (size_t i = 0; i < std::size(metricPhases); ++i)
+            if (phase == metricPhases[i])
+                phases[i].observe(seconds);
     }
     
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        std::set<std::string> deps;
-        std::regex requireRegex("require\\(['\"]([^\\.][^'\"]*)['\"]\\)");
-        std::regex importRegex("import\\s+.*?['\"]([^\\.][^'\"]*)['\"]");
-        for (const auto &entry : fs::recursive_directory_iterator(folderPath)) {
-            if (entry.is_regular_file()) {
-                std::string ext = entry.path().extension().string();
-                if (ext == ".js" || ext == ".ts") {
-                    std::ifstream file(entry.path());
-                    std::string line;
-                    while (std::getline(file, line)) {
-                        std::smatch match;
-                        if (std::regex_search(line, match, requireRegex))
-                            deps.insert(match[1]);
-                        else if (std::regex_search(line, match, importRegex))
-                            deps.insert(match[1]);
-                    }
-                }
-            }
-        }
-        return deps;
+    void countRequest(const std::string &method) {
+        size_t i = 0;
+        while (i + 1 < std::size(cacheServerMethods) && method != cacheServerMethods[i])
+            ++i;
+        cacheServerRequests[i].add();
     }
     
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM node:14\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        if (fileExistsInFolder(folderPath, "package.json"))
-            docker += "RUN npm install\n";
-        else if (!deps.empty()) {
-            docker += "RUN npm install";
-            for (const auto &dep : deps)
-                docker += " " + dep;
-            docker += "\n";
-        }
-        docker += "CMD [\"npm\", \"start\"]\n";
-        return docker;
+    std::string render() const {
+        std::string out;
+        auto head = [&](const char *name, const char *type, const char *help) {
+            out += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+        };
+        auto line = [&](const std::string &series, uint64_t value) { out += series + " " + std::to_string(value) + "\n"; };
+        auto ratio = [&](const char *cache, uint64_t hits, uint64_t misses) {
+            char value[32];
+            std::snprintf(value, sizeof(value), "%.4f", hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0);
+            out += std::string("operator_cache_hit_ratio{cache=\"") + cache + "\"} " + value + "\n";
+        };
+        head("operator_projects_total", "counter", "Projects scanned.");
+        line("operator_projects_total", projects.value());
+        head("operator_files_scanned_total", "counter", "Files indexed while scanning projects.");
+        line("operator_files_scanned_total", filesScanned.value());
+        head("operator_bytes_read_total", "counter", "Bytes of project files read for detection, extraction and hashing.");
+        line("operator_bytes_read_total", bytesRead.value());
+        head("operator_phase_duration_seconds", "histogram", "Time spent per scan and generation phase.");
+        for (size_t i = 0; i < std::size(metricPhases); ++i)
+            phases[i].render(out, "operator_phase_duration_seconds", std::string("phase=\"") + metricPhases[i] + "\"");
+        head("operator_file_hash_cache_lookups_total", "counter", "Fingerprint file hash cache lookups.");
+        line("operator_file_hash_cache_lookups_total{result=\"hit\"}", fileHashHits.value());
+        line("operator_file_hash_cache_lookups_total{result=\"miss\"}", fileHashMisses.value());
+        head("operator_cache_server_requests_total", "counter", "Compile cache server requests by method.");
+        for (size_t i = 0; i < std::size(cacheServerMethods); ++i)
+            line(std::string("operator_cache_server_requests_total{method=\"") + cacheServerMethods[i] + "\"}",
+                 cacheServerRequests[i].value());
+        head("operator_compile_cache_lookups_total", "counter", "Compile cache server object lookups.");
+        line("operator_compile_cache_lookups_total{result=\"hit\"}", compileCacheHits.value());
+        line("operator_compile_cache_lookups_total{result=\"miss\"}", compileCacheMisses.value());
+        head("operator_compile_cache_stores_total", "counter", "Objects stored in the compile cache server.");
+        line("operator_compile_cache_stores_total", compileCacheStores.value());
+        head("operator_compile_cache_stored_bytes_total", "counter", "Bytes stored in the compile cache server.");
+        line("operator_compile_cache_stored_bytes_total", compileCacheStoredBytes.value());
+        head("operator_cache_hit_ratio", "gauge", "Hits over lookups since start.");
+        ratio("file_hash", fileHashHits.value(), fileHashMisses.value());
+        ratio("compile", compileCacheHits.value(), compileCacheMisses.value());
+        return out;
     }
 };
 
-class JavaHandler : public LanguageHandler {
+OperatorMetrics operatorMetrics;
+
+// Written to a temporary file and renamed, so the textfile collector never reads a partial file.
+bool writeMetricsFile(const std::string &path) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary);
+        out << operatorMetrics.render();
+        if (!out) {
+            std::cerr << "메트릭 파일을 쓸 수 없습니다: " << path << "\n";
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temporary, path, ec);
+    return !ec;
+}
+
+// --background: project files are read through a token bucket (--read-limit bytes per second, one second of
+// burst) with at most --max-open-files of them open at once, so a large scan leaves the disk to the builds
+// running next to it. Both are no-ops unless configured.
+class ReadThrottle {
 public:
-    std::string getName() const override { return "Java"; }
-    
-    bool detect(const std::string &folderPath) override {
-        if (fileExistsInFolder(folderPath, "pom.xml") || fileExistsInFolder(folderPath, "build.gradle"))
-            return true;
-        if (fileWithExtensionExists(folderPath, ".java"))
-            return true;
-        return false;
+    void setRate(uint64_t bytesPerSecond) {
+        rate = bytesPerSecond;
+        tokens = static_cast<double>(rate);
+        refilled = std::chrono::steady_clock::now();
     }
     
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        std::set<std::string> deps;
-        std::regex importRegex("^\\s*import\\s+([a-zA-Z0-9_\\.]+)");
-        for (const auto &entry : fs::recursive_directory_iterator(folderPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".java") {
-                std::ifstream file(entry.path());
-                std::string line;
-                while (std::getline(file, line)) {
-                    std::smatch match;
-                    if (std::regex_search(line, match, importRegex))
-                        deps.insert(match[1]);
-                }
-            }
-        }
-        return deps;
+    // Charges bytes already read and sleeps off any debt; concurrent readers queue behind each other's debt.
+    void consume(size_t bytes) {
+        if (!rate)
+            return;
+        std::unique_lock<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        tokens = std::min(static_cast<double>(rate),
+                          tokens + std::chrono::duration<double>(now - refilled).count() * static_cast<double>(rate));
+        refilled = now;
+        tokens -= static_cast<double>(bytes);
+        if (tokens >= 0)
+            return;
+        auto wait = std::chrono::duration<double>(-tokens / static_cast<double>(rate));
+        lock.unlock();
+        std::this_thread::sleep_for(wait);
     }
     
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM openjdk:11\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        if (fileExistsInFolder(folderPath, "pom.xml")) {
-            docker += "RUN mvn install\n";
-            docker += "CMD [\"java\", \"-jar\", \"target/app.jar\"]\n";
-        } else if (fileExistsInFolder(folderPath, "build.gradle")) {
-            docker += "RUN gradle build\n";
-            docker += "CMD [\"java\", \"-jar\", \"build/libs/app.jar\"]\n";
-        } else {
-            docker += "# TODO: Java 빌드 명령어 추가\n";
-        }
-        return docker;
-    }
+private:
+    uint64_t rate = 0;
+    double tokens = 0;
+    std::chrono::steady_clock::time_point refilled;
+    std::mutex mutex;
 };
 
-class RubyHandler : public LanguageHandler {
+class OpenFileLimit {
 public:
-    std::string getName() const override { return "Ruby"; }
+    void setLimit(unsigned files) { limit = files; }
     
-    bool detect(const std::string &folderPath) override {
-        if (fileExistsInFolder(folderPath, "Gemfile"))
-            return true;
-        if (fileWithExtensionExists(folderPath, ".rb"))
-            return true;
-        return false;
+    void acquire() {
+        if (!limit)
+            return;
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [&] { return open < limit; });
+        ++open;
     }
     
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        std::set<std::string> deps;
-        std::regex requireRegex("require\\s+['\"]([^'\"]+)['\"]");
-        for (const auto &entry : fs::recursive_directory_iterator(folderPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".rb") {
-                std::ifstream file(entry.path());
-                std::string line;
-                while (std::getline(file, line)) {
-                    std::smatch match;
-                    if (std::regex_search(line, match, requireRegex)) {
-                        std::string dep = match[1];
-                        if (!dep.empty() && dep[0] != '.')
-                            deps.insert(dep);
-                    }
-                }
-            }
+    void release() {
+        if (!limit)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --open;
         }
-        return deps;
+        available.notify_one();
     }
     
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM ruby:2.7\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        if (fileExistsInFolder(folderPath, "Gemfile"))
-            docker += "RUN bundle install\n";
-        else if (!deps.empty()) {
-            docker += "RUN gem install";
-            for (const auto &dep : deps)
-                docker += " " + dep;
-            docker += "\n";
-        }
-        docker += "CMD [\"ruby\", \"main.rb\"]\n";
-        return docker;
-    }
+private:
+    unsigned limit = 0;
+    unsigned open = 0;
+    std::mutex mutex;
+    std::condition_variable available;
 };
 
-class PHPHandler : public LanguageHandler {
+ReadThrottle readThrottle;
+OpenFileLimit openFileLimit;
+
+// Held for as long as a project file is open.
+class OpenFileSlot {
 public:
-    std::string getName() const override { return "PHP"; }
-    
-    bool detect(const std::string &folderPath) override {
-        if (fileExistsInFolder(folderPath, "composer.json"))
-            return true;
-        if (fileWithExtensionExists(folderPath, ".php"))
-            return true;
+    OpenFileSlot() { openFileLimit.acquire(); }
+    ~OpenFileSlot() { openFileLimit.release(); }
+    OpenFileSlot(const OpenFileSlot &) = delete;
+    OpenFileSlot &operator=(const OpenFileSlot &) = delete;
+};
+
+// Idle I/O class (best-effort level 7 when idle is refused) and nice 19. On Linux both apply to the calling
+// thread only, so this runs before any thread starts (including the event writer) and every thread inherits them.
+bool lowerProcessPriority() {
+    bool io = false;
+#ifdef SYS_ioprio_set
+    const int whoProcess = 1, classShift = 13, idleClass = 3, bestEffortClass = 2;
+    io = syscall(SYS_ioprio_set, whoProcess, 0, idleClass << classShift) == 0 ||
+         syscall(SYS_ioprio_set, whoProcess, 0, (bestEffortClass << classShift) | 7) == 0;
+#endif
+    bool cpu = setpriority(PRIO_PROCESS, 0, 19) == 0;
+    return io && cpu;
+}
+
+// Plain decimal digits up to `max`; false on signs, suffixes, overflow or an empty value.
+bool parseCount(const std::string &text, uint64_t max, uint64_t &value) {
+    if (text.empty() || text.size() > 19 || text.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    value = std::strtoull(text.c_str(), nullptr, 10);
+    return value <= max;
+}
+
+// "64M", "512K", "1G" or plain bytes; false on anything else.
+bool parseByteSize(const std::string &text, uint64_t &bytes) {
+    char *end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str())
+        return false;
+    std::string unit = end;
+    if (unit.size() > 1)
+        return false;
+    const std::string units = "kmg";
+    size_t shift = unit.empty() ? 0 : units.find(static_cast<char>(std::tolower(static_cast<unsigned char>(unit[0]))));
+    if (shift == std::string::npos)
+        return false;
+    bytes = value << (unit.empty() ? 0 : 10 * (shift + 1));
+    return true;
+}
+
+// Installed dependencies and tool caches: never project sources at any depth, and often most of the tree.
+const std::set<std::string> indexIgnoreDirs = {"node_modules", "__pycache__", ".venv", ".tox", ".gradle"};
+// Build output and vendored trees at the project root; deeper down the same names are ordinary packages
+// (a Go `internal/build`, a Python `myapp/build/`).
+const std::set<std::string> indexIgnoreRootDirs = {".git", ".operator", "vendor", "target", "build", "dist", "obj", "venv"};
+
+// Reads a project file in chunks, charging each chunk's real size to --read-limit before it is used.
+template <typename Consumer>
+bool readFileChunks(const fs::path &path, Consumer consume) {
+    OpenFileSlot slot;
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
         return false;
+    char chunk[1 << 16];
+    while (file) {
+        file.read(chunk, sizeof(chunk));
+        size_t got = static_cast<size_t>(file.gcount());
+        if (got == 0)
+            break;
+        readThrottle.consume(got);
+        operatorMetrics.bytesRead.add(got);
+        consume(chunk, got);
     }
-    
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        std::set<std::string> deps;
-        std::regex requireRegex("(require|include)\\s*\\(?\\s*['\"]([^'\"]+)['\"]");
-        for (const auto &entry : fs::recursive_directory_iterator(folderPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".php") {
-                std::ifstream file(entry.path());
-                std::string line;
-                while (std::getline(file, line)) {
-                    std::smatch match;
-                    if (std::regex_search(line, match, requireRegex))
-                        deps.insert(match[2]);
-                }
+    return !file.bad();
+}
+
+// One walk per project, shared by every handler's detect and extract step. Manifest-sized files are
+// read on first use and kept, so a file read by several handlers (or plugins) comes from disk once;
+// source scans stream instead (scanImports).
+class ProjectIndex {
+public:
+    explicit ProjectIndex(const std::string &folderPath) : root(folderPath) {
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+             it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec)
+                break;
+            if (it->is_directory(ec)) {
+                std::string name = it->path().filename().string();
+                if ((it.depth() == 0 && indexIgnoreRootDirs.count(name)) || indexIgnoreDirs.count(name))
+                    it.disable_recursion_pending();
+                continue;
+            }
+            if (it->is_regular_file(ec)) {
+                std::string extension = it->path().extension().string();
+                byExtension[extension].push_back(it->path());
+                relativeByExtension[extension].push_back(it->path().lexically_relative(root).generic_string());
+                ++files;
             }
         }
-        return deps;
+        operatorMetrics.projects.add();
+        operatorMetrics.filesScanned.add(files);
     }
     
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM php:7.4-apache\n";
-        docker += "WORKDIR /var/www/html\n";
-        docker += "COPY . /var/www/html\n";
-        if (fileExistsInFolder(folderPath, "composer.json"))
-            docker += "RUN composer install\n";
-        else if (!deps.empty()) {
-            docker += "RUN composer require";
-            for (const auto &dep : deps)
-                docker += " " + dep;
-            docker += "\n";
-        }
-        docker += "CMD [\"apache2-foreground\"]\n";
-        return docker;
+    const fs::path &rootPath() const { return root; }
+    
+    const std::vector<fs::path> &filesWithExtension(const std::string &extension) const {
+        static const std::vector<fs::path> none;
+        auto it = byExtension.find(extension);
+        return it == byExtension.end() ? none : it->second;
     }
-};
-
-class GoHandler : public LanguageHandler {
-public:
-    std::string getName() const override { return "Go"; }
     
-    bool detect(const std::string &folderPath) override {
-        if (fileExistsInFolder(folderPath, "go.mod"))
-            return true;
-        if (fileWithExtensionExists(folderPath, ".go"))
-            return true;
-        return false;
+    const std::vector<std::string> &relativeFilesWithExtension(const std::string &extension) const {
+        static const std::vector<std::string> none;
+        auto it = relativeByExtension.find(extension);
+        return it == relativeByExtension.end() ? none : it->second;
     }
     
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        std::set<std::string> deps;
-        std::regex importRegex("^\\s*import\\s+\"([^\"]+)\"");
-        for (const auto &entry : fs::recursive_directory_iterator(folderPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".go") {
-                std::ifstream file(entry.path());
-                std::string line;
-                while (std::getline(file, line)) {
-                    std::smatch match;
-                    if (std::regex_search(line, match, importRegex))
-                        deps.insert(match[1]);
-                }
-            }
+    bool hasExtension(const std::string &extension) const { return byExtension.count(extension) > 0; }
+    
+    size_t fileCount() const { return files; }
+    
+    // The read happens outside the lock, so a throttled read does not hold up cached lookups; when two
+    // threads read the same file, the first to finish is kept.
+    const std::string &contents(const fs::path &path) const {
+        {
+            std::lock_guard<std::mutex> lock(contentsMutex);
+            auto it = contentsCache.find(path.string());
+            if (it != contentsCache.end())
+                return it->second;
         }
-        return deps;
+        std::string data;
+        readFileChunks(path, [&](const char *chunk, size_t size) { data.append(chunk, size); });
+        std::lock_guard<std::mutex> lock(contentsMutex);
+        return contentsCache.emplace(path.string(), std::move(data)).first->second;
     }
     
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM golang:1.16\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        if (fileExistsInFolder(folderPath, "go.mod"))
-            docker += "RUN go mod download\n";
-        docker += "RUN go build -o main .\n";
-        docker += "CMD [\"./main\"]\n";
-        return docker;
-    }
+private:
+    fs::path root;
+    std::map<std::string, std::vector<fs::path>> byExtension;
+    std::map<std::string, std::vector<std::string>> relativeByExtension;
+    size_t files = 0;
+    mutable std::mutex contentsMutex;
+    mutable std::map<std::string, std::string> contentsCache;
 };
 
-class CSharpHandler : public LanguageHandler {
+std::mutex projectIndexMutex;
+std::map<std::string, std::unique_ptr<ProjectIndex>> projectIndexes;
+
+const ProjectIndex &projectIndex(const std::string &folderPath) {
+    std::string key = fs::absolute(folderPath).lexically_normal().string();
+    std::lock_guard<std::mutex> lock(projectIndexMutex);
+    auto &index = projectIndexes[key];
+    if (!index)
+        index = std::make_unique<ProjectIndex>(folderPath);
+    return *index;
+}
+
+// Drops the index and its cached file contents once a project is done (batch runs over many projects).
+void releaseProjectIndex(const std::string &folderPath) {
+    std::lock_guard<std::mutex> lock(projectIndexMutex);
+    projectIndexes.erase(fs::absolute(folderPath).lexically_normal().string());
+}
+
+bool fileWithExtensionExists(const std::string &folderPath, const std::string &extension) {
+    return projectIndex(folderPath).hasExtension(extension);
+}
+
+// Import patterns each carry exactly one capture group (the dependency name); a set of them is
+// compiled into a single alternation so every line is matched once, whatever the pattern count.
+class PatternSet {
 public:
-    std::string getName() const override { return "C# (.NET)"; }
+    explicit PatternSet(const std::vector<std::string> &patterns) {
+        std::string combined;
+        for (const auto &pattern : patterns)
+            combined += (combined.empty() ? "(?:" : "|(?:") + pattern + ")";
+        regex = std::regex(combined.empty() ? "$^" : combined);
+    }
     
-    bool detect(const std::string &folderPath) override {
-        if (fileWithExtensionExists(folderPath, ".cs"))
-            return true;
-        for (const auto &entry : fs::directory_iterator(folderPath)) {
-            if (entry.is_regular_file()) {
-                std::string fname = entry.path().filename().string();
-                if (fname.size() >= 6 && fname.substr(fname.size() - 6) == ".csproj")
-                    return true;
-                if (fname.size() >= 4 && fname.substr(fname.size() - 4) == ".sln")
-                    return true;
+    bool search(const std::string &line, std::string &capture) const {
+        std::smatch match;
+        if (!std::regex_search(line, match, regex))
+            return false;
+        for (size_t i = 1; i < match.size(); ++i) {
+            if (match[i].matched) {
+                capture = match[i];
+                return true;
             }
         }
         return false;
     }
     
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        return {};
-    }
-    
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM mcr.microsoft.com/dotnet/sdk:5.0\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        docker += "RUN dotnet restore\n";
-        docker += "RUN dotnet build\n";
-        docker += "CMD [\"dotnet\", \"run\"]\n";
-        return docker;
-    }
+private:
+    std::regex regex;
 };
 
-class CppHandler : public LanguageHandler {
-public:
-    std::string getName() const override { return "C++"; }
-    
-    bool detect(const std::string &folderPath) override {
-        if (fileWithExtensionExists(folderPath, ".cpp") ||
-            fileWithExtensionExists(folderPath, ".cc") ||
-            fileWithExtensionExists(folderPath, ".cxx"))
-            return true;
-        return false;
-    }
-    
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        return {};
-    }
-    
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM gcc:latest\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        docker += "RUN g++ -o main *.cpp\n";
-        docker += "CMD [\"./main\"]\n";
-        return docker;
+std::set<std::string> scanImports(const std::string &folderPath, const std::vector<std::string> &extensions,
+                                  const PatternSet &patterns) {
+    std::set<std::string> deps;
+    const auto &index = projectIndex(folderPath);
+    for (const auto &extension : extensions) {
+        for (const auto &path : index.filesWithExtension(extension)) {
+            std::string line, dep;
+            readFileChunks(path, [&](const char *data, size_t size) {
+                for (size_t i = 0; i < size; ++i) {
+                    if (data[i] != '\n') {
+                        line += data[i];
+                        continue;
+                    }
+                    if (patterns.search(line, dep))
+                        deps.insert(dep);
+                    line.clear();
+                }
+            });
+            if (!line.empty() && patterns.search(line, dep))
+                deps.insert(dep);
+        }
     }
+    return deps;
+}
+
+struct NativeRequirement {
+    const char *package;
+    const char *buildPackages;
+    const char *runtimePackages;
+    const char *binaryVariant;
 };
 
-class RustHandler : public LanguageHandler {
-public:
-    std::string getName() const override { return "Rust"; }
-    
-    bool detect(const std::string &folderPath) override {
-        if (fileExistsInFolder(folderPath, "Cargo.toml"))
-            return true;
-        if (fileWithExtensionExists(folderPath, ".rs"))
-            return true;
-        return false;
-    }
-    
-    std::set<std::string> extractDependencies(const std::string &folderPath) override {
-        return {};
-    }
+// Python keys cover both the distribution name and the import name.
+const NativeRequirement pythonNativeRequirements[] = {
+    {"psycopg2",    "gcc libpq-dev",                                   "libpq5",                       "psycopg2-binary"},
+    {"mysqlclient", "gcc pkg-config default-libmysqlclient-dev",       "libmariadb3",                  nullptr},
+    {"MySQLdb",     "gcc pkg-config default-libmysqlclient-dev",       "libmariadb3",                  nullptr},
+    {"lxml",        "gcc libxml2-dev libxslt1-dev",                    "libxml2 libxslt1.1",           nullptr},
+    {"bcrypt",      "gcc libffi-dev",                                  "",                             nullptr},
+    {"cffi",        "gcc libffi-dev",                                  "libffi8",                      nullptr},
+    {"cryptography","gcc libssl-dev libffi-dev",                       "",                             nullptr},
+    {"Pillow",      "gcc libjpeg62-turbo-dev zlib1g-dev libpng-dev",   "libjpeg62-turbo libpng16-16",  nullptr},
+    {"PIL",         "gcc libjpeg62-turbo-dev zlib1g-dev libpng-dev",   "libjpeg62-turbo libpng16-16",  nullptr},
+    {"PyYAML",      "gcc libyaml-dev",                                 "libyaml-0-2",                  nullptr},
+    {"yaml",        "gcc libyaml-dev",                                 "libyaml-0-2",                  nullptr},
+    {"pycurl",      "gcc libcurl4-openssl-dev libssl-dev",             "libcurl4",                     nullptr},
+    {"python-ldap", "gcc libldap2-dev libsasl2-dev",                   "libldap-2.5-0 libsasl2-2",     nullptr},
+    {"ldap",        "gcc libldap2-dev libsasl2-dev",                   "libldap-2.5-0 libsasl2-2",     nullptr},
+    {"uwsgi",       "gcc",                                             "",                             nullptr},
+    {"gevent",      "gcc",                                             "",                             nullptr},
+};
+
+// node-gyp addons: prebuild-install fetches binaries when available, the toolchain is the fallback.
+const NativeRequirement nodeNativeRequirements[] = {
+    {"bcrypt",         "python3 make g++",                              "",                          nullptr},
+    {"argon2",         "python3 make g++",                              "",                          nullptr},
+    {"sqlite3",        "python3 make g++",                              "",                          nullptr},
+    {"better-sqlite3", "python3 make g++",                              "",                          nullptr},
+    {"node-sass",      "python3 make g++",                              "",                          nullptr},
+    {"pg-native",      "python3 make g++ libpq-dev",                    "libpq5",                    nullptr},
+    {"kerberos",       "python3 make g++ libkrb5-dev",                  "libgssapi-krb5-2",          nullptr},
+    {"canvas",         "python3 make g++ libcairo2-dev libpango1.0-dev libjpeg-dev libgif-dev librsvg2-dev",
+                       "libcairo2 libpango-1.0-0 libpangocairo-1.0-0 libjpeg62-turbo libgif7 librsvg2-2", nullptr},
+};
+
+struct NativeBuildPlan {
+    std::set<std::string> buildPackages;
+    std::set<std::string> runtimePackages;
+    std::vector<std::pair<std::string, std::string>> binarySubstitutions;
     
-    std::string generateDockerfile(const std::string &folderPath, const std::set<std::string> &deps) override {
-        std::string docker;
-        docker += "FROM rust:latest\n";
-        docker += "WORKDIR /app\n";
-        docker += "COPY . /app\n";
-        if (fileExistsInFolder(folderPath, "Cargo.toml"))
-            docker += "RUN cargo build --release\n";
-        else
-            docker += "# Cargo.toml 파일을 추가하여 의존성 관리를 해주세요\n";
-        docker += "CMD [\"./target/release/<your_binary>\"]\n";
-        return docker;
-    }
+    bool empty() const { return buildPackages.empty() && runtimePackages.empty(); }
 };
 
-void displayBanner() {
-    std::cout << R"(               
-    ____ ______   ________________ _/  |_  ___________ 
-   /  _ \\____ \_/ __ \_  __ \__  \\   __\/  _ \_  __ \
-  (  <_> )  |_> >  ___/|  | \// __ \|  | (  <_> )  | \/
-   \____/|   __/ \___  >__|  (____  /__|  \____/|__|   
-         |__|        \/           \/                   
-  
-  developed by seoyulh92
-  MIT License
-  0.0.1
-)" << "\n";
+std::string lowercase(std::string text) {
+    for (auto &c : text)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+void splitInto(std::set<std::string> &out, const std::string &words) {
+    std::istringstream in(words);
+    std::string word;
+    while (in >> word)
+        out.insert(word);
 }
 
-void initializeLanguageListFile() {
-    fs::path langFilePath("langlist.operator");
-    if (!fs::exists(langFilePath)) {
-        std::ofstream out(langFilePath);
-        if (out.is_open()) {
-            out << "Python\n";
-            out << "Node.js\n";
-            out << "Java\n";
-            out << "Ruby\n";
-            out << "PHP\n";
-            out << "Go\n";
-            out << "C# (.NET)\n";
-            out << "C++\n";
-            out << "Rust\n";
-            std::cout << "[langlist.operator 파일이 생성되었습니다. 기본 지원 언어가 저장되었습니다.]\n";
-            std::cout << "파일 경로: " << fs::absolute(langFilePath) << "\n\n";
+template <size_t N>
+NativeBuildPlan planNativeBuild(const NativeRequirement (&table)[N], const std::set<std::string> &packages) {
+    NativeBuildPlan plan;
+    std::set<std::string> seen;
+    for (const auto &package : packages) {
+        for (const auto &req : table) {
+            if (lowercase(req.package) != lowercase(package))
+                continue;
+            splitInto(plan.buildPackages, req.buildPackages);
+            splitInto(plan.runtimePackages, req.runtimePackages);
+            if (req.binaryVariant && seen.insert(req.binaryVariant).second)
+                plan.binarySubstitutions.emplace_back(package, req.binaryVariant);
         }
-        out.close();
     }
+    return plan;
 }
 
-void addNewLanguage() {
-    std::cin.ignore();
-    std::cout << "\n추가할 새로운 언어 이름을 입력하세요: ";
-    std::string newLang;
-    std::getline(std::cin, newLang);
-    if (newLang.empty()) {
-        std::cout << "입력값이 없습니다.\n";
-        return;
+std::string aptInstall(const std::set<std::string> &packages) {
+    std::string cmd = "apt-get install -y --no-install-recommends";
+    for (const auto &pkg : packages)
+        cmd += " " + pkg;
+    return cmd;
+}
+
+std::set<std::string> readRequirementNames(const std::string &folderPath) {
+    std::set<std::string> names;
+    std::ifstream file(fs::path(folderPath) / "requirements.txt");
+    std::regex nameRegex("^\\s*([A-Za-z0-9][A-Za-z0-9._-]*)");
+    std::string line;
+    while (std::getline(file, line)) {
+        std::smatch match;
+        if (std::regex_search(line, match, nameRegex))
+            names.insert(match[1]);
     }
-    
-    fs::path langFilePath("langlist.operator");
-    std::ofstream out(langFilePath, std::ios::app);
-    if (out.is_open()) {
-        out << newLang << "\n";
-        out.close();
-        std::cout << "새로운 언어가 추가되었습니다: " << newLang << "\n";
-    } else {
-        std::cerr << "langlist.operator 파일에 접근할 수 없습니다.\n";
+    return names;
+}
+
+std::set<std::string> readPackageJsonDependencies(const std::string &folderPath) {
+    std::set<std::string> names;
+    std::ifstream file(fs::path(folderPath) / "package.json");
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::regex sectionRegex("\"(dependencies|optionalDependencies)\"\\s*:\\s*\\{([^}]*)\\}");
+    std::regex keyRegex("\"([^\"]+)\"\\s*:");
+    for (std::sregex_iterator it(content.begin(), content.end(), sectionRegex), end; it != end; ++it) {
+        std::string body = (*it)[2];
+        for (std::sregex_iterator key(body.begin(), body.end(), keyRegex); key != end; ++key)
+            names.insert((*key)[1]);
     }
+    return names;
 }
 
-void makeDockerfileOperation() {
-    std::cout << "\n==== Operator ====\n";
-    std::cout << "프로젝트 폴더 경로를 입력하세요: ";
-    std::string folderPath;
-    std::cin.ignore();
-    std::getline(std::cin, folderPath);
-    
-    while (!fs::exists(folderPath) || !fs::is_directory(folderPath)) {
-        std::cout << "유효하지 않은 폴더입니다. 다시 입력하세요: ";
-        std::getline(std::cin, folderPath);
+struct OperatorOptions {
+    bool offline = false;
+    std::string output = "-";
+    std::string compression = "gzip";
+    unsigned threads = 0;
+    std::string org;
+    std::vector<std::string> platforms;
+    std::string pgoTraining;
+    std::string compileCache;
+    int cacheServerPort = 8080;
+    std::string cacheServerBind;
+    bool nativeImage = false;
+    std::string nativeImageTraining;
+    std::set<std::string> nodeStartup;
+    std::string metricsPath;
+    std::string eventsPath;
+    bool background = false;
+    uint64_t readLimit = 0;
+    unsigned maxOpenFiles = 0;
+    bool readLimitSet = false;
+    bool maxOpenFilesSet = false;
+    uint64_t memoryLimit = 0;
+    bool memoryLimitSet = false;
+};
+
+OperatorOptions operatorOptions;
+
+const std::string vendorDir = ".operator/vendor";
+
+bool vendorCacheExists(const std::string &folderPath, const std::string &name) {
+    return fs::exists(fs::path(folderPath) / vendorDir / name);
+}
+
+bool useVendorCache(const std::string &folderPath, const std::string &name) {
+    return operatorOptions.offline && vendorCacheExists(folderPath, name);
+}
+
+long long fileTimeNanos(fs::file_time_type time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+fs::path operatorCacheDir() {
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"))
+        return fs::path(xdg) / "operator";
+    if (const char *home = std::getenv("HOME"))
+        return fs::path(home) / ".cache" / "operator";
+    return fs::temp_directory_path() / "operator";
+}
+
+std::string shellQuote(const std::string &text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'')
+            quoted += "'\\''";
+        else
+            quoted += c;
     }
-    
+    return quoted + "'";
+}
+
+std::vector<std::string> splitWords(const std::string &text) {
+    std::vector<std::string> words;
+    std::istringstream in(text);
+    std::string word;
+    while (in >> word)
+        words.push_back(word);
+    return words;
+}
+
+std::string trim(const std::string &text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string::npos)
+        return "";
+    return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+}
+
+enum class DockerOp { Run, Copy, Env, Arg, Workdir, Cmd, Entrypoint, Expose, Label, User, Comment, Other };
+
+struct DockerInstruction {
+    DockerOp op = DockerOp::Other;
+    std::string keyword;
+    std::vector<std::string> flags;
+    std::string args;
+    std::vector<std::string> commands;
+    std::vector<std::string> inputs;
+    std::string heredoc;
+    int line = 0;
+};
+
+struct DockerStage {
+    std::string comment;
+    std::vector<std::string> fromFlags;
+    std::string image;
+    std::string name;
+    int line = 0;
+    std::vector<DockerInstruction> instructions;
+};
+
+std::string jsonString(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+            continue;
+        }
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::string jsonArray(const std::vector<std::string> &items) {
+    std::string array = "[";
+    for (const auto &item : items)
+        array += (array.size() > 1 ? ", " : "") + jsonString(item);
+    return array + "]";
+}
+
+std::string jsonNumber(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f", value);
+    return text;
+}
+
+// NDJSON progress events for batch and daemon consumers (--events=<path>). Producers push onto a lock-free
+// list and never wait for I/O; a writer thread takes the whole list at once and writes it in emit order.
+class EventStream {
+public:
+    using Field = std::pair<const char *, std::string>;
+    
+    bool open(const std::string &path) {
+        out = std::fopen(path.c_str(), "w");
+        if (!out)
+            return false;
+        writer = std::thread([this] {
+            while (!stopping.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                drain();
+            }
+        });
+        return true;
+    }
+    
+    bool enabled() const { return out != nullptr; }
+    
+    // Field values are JSON already (jsonString, jsonNumber, ...).
+    void emit(const char *type, const std::vector<Field> &fields = {}) {
+        if (!out)
+            return;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        Node *node = new Node;
+        node->line = "{\"event\":" + jsonString(type) + ",\"ms\":" + jsonNumber(ms);
+        for (const auto &field : fields)
+            node->line += ",\"" + std::string(field.first) + "\":" + field.second;
+        node->line += "}\n";
+        node->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+    
+    // Also feeds the phase latency histogram, whether or not events are written.
+    void phase(const char *name, std::chrono::steady_clock::time_point since, const std::vector<Field> &fields = {}) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+        operatorMetrics.observePhase(name, ms / 1000);
+        if (!out)
+            return;
+        std::vector<Field> all = {{"phase", jsonString(name)}, {"duration_ms", jsonNumber(ms)}};
+        all.insert(all.end(), fields.begin(), fields.end());
+        emit("phase", all);
+    }
+    
+    void close() {
+        if (!out)
+            return;
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+        drain();
+        std::fclose(out);
+        out = nullptr;
+    }
+    
+    ~EventStream() { close(); }
+    
+private:
+    struct Node {
+        std::string line;
+        Node *next = nullptr;
+    };
+    
+    void drain() {
+        Node *list = head.exchange(nullptr, std::memory_order_acquire);
+        Node *ordered = nullptr;
+        while (list) {
+            Node *next = list->next;
+            list->next = ordered;
+            ordered = list;
+            list = next;
+        }
+        std::string batch;
+        while (ordered) {
+            batch += ordered->line;
+            Node *next = ordered->next;
+            delete ordered;
+            ordered = next;
+        }
+        if (!batch.empty()) {
+            std::fwrite(batch.data(), 1, batch.size(), out);
+            std::fflush(out);
+        }
+    }
+    
+    FILE *out = nullptr;
+    std::atomic<Node *> head{nullptr};
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+};
+
+EventStream eventStream;
+
+// Splits "a && b && c" at top-level && only (outside quotes, parentheses and braces).
+std::vector<std::string> splitShellAnd(const std::string &command) {
+    std::vector<std::string> parts;
+    std::string current;
+    int depth = 0;
+    char quote = 0;
+    for (size_t i = 0; i < command.size(); ++i) {
+        char c = command[i];
+        if (quote) {
+            if (c == '\\' && quote == '"' && i + 1 < command.size()) {
+                current += c;
+                c = command[++i];
+            } else if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == '(' || c == '{') {
+            ++depth;
+        } else if ((c == ')' || c == '}') && depth > 0) {
+            --depth;
+        } else if (c == '&' && depth == 0 && i + 1 < command.size() && command[i + 1] == '&') {
+            parts.push_back(trim(current));
+            current.clear();
+            ++i;
+            continue;
+        }
+        current += c;
+    }
+    if (!trim(current).empty() || parts.empty())
+        parts.push_back(trim(current));
+    return parts;
+}
+
+std::string joinWords(const std::set<std::string> &words) {
+    std::string joined;
+    for (const auto &word : words)
+        joined += (joined.empty() ? "" : " ") + word;
+    return joined;
+}
+
+// A compose.dev.yaml service running a `dev` stage with the project bind-mounted at workdir.
+// volumes are container paths kept out of the bind mount (installed dependencies, build output).
+struct DevService {
+    std::string name;
+    std::string stage;
+    std::string workdir = "/app";
+    std::vector<std::string> volumes;
+    std::vector<std::string> ports;
+};
+
+// Handlers describe their image as stages of typed instructions; the optimization passes rewrite
+// this structure and render() turns it into text exactly once. A RUN keeps its shell commands as a
+// list (merged RUNs are just longer lists) and the context files it reads in `inputs`, which lets
+// the ordering pass copy those files ahead of the whole-context COPY.
+class DockerfileIR {
+public:
+    std::vector<std::string> preamble;
+    std::vector<DockerStage> stages;
+    // Files the Dockerfile expects in its build context (absolute path -> content); written by `make`.
+    std::map<std::string, std::string> generatedFiles;
+    std::vector<DevService> devServices;
+    
+    DockerStage &from(const std::string &image, const std::string &name = "") {
+        stages.emplace_back();
+        stages.back().image = image;
+        stages.back().name = name;
+        return stages.back();
+    }
+    
+    DockerfileIR &run(const std::string &command, std::vector<std::string> inputs = {}) {
+        DockerInstruction &instruction = add(DockerOp::Run, "RUN", "");
+        instruction.commands = splitShellAnd(command);
+        instruction.inputs = std::move(inputs);
+        return *this;
+    }
+    
+    // Commands that only read vendored artifacts; with --offline they run without a network.
+    DockerfileIR &offlineRun(const std::string &command, std::vector<std::string> inputs = {}) {
+        run(command, std::move(inputs));
+        if (operatorOptions.offline)
+            last().flags.push_back("--network=none");
+        return *this;
+    }
+    
+    DockerfileIR &copy(const std::string &args) {
+        add(DockerOp::Copy, "COPY", args);
+        return *this;
+    }
+    
+    DockerfileIR &copyFrom(const std::string &stage, const std::string &args) {
+        add(DockerOp::Copy, "COPY", args).flags.push_back("--from=" + stage);
+        return *this;
+    }
+    
+    DockerfileIR &env(const std::string &key, const std::string &value) {
+        add(DockerOp::Env, "ENV", key + "=" + value);
+        return *this;
+    }
+    
+    DockerfileIR &arg(const std::string &args) {
+        add(DockerOp::Arg, "ARG", args);
+        return *this;
+    }
+    
+    DockerfileIR &workdir(const std::string &path) {
+        add(DockerOp::Workdir, "WORKDIR", path);
+        return *this;
+    }
+    
+    DockerfileIR &cmd(const std::vector<std::string> &argv) {
+        add(DockerOp::Cmd, "CMD", jsonArray(argv));
+        return *this;
+    }
+    
+    DockerfileIR &comment(const std::string &text) {
+        add(DockerOp::Comment, "#", text);
+        return *this;
+    }
+    
+    DockerfileIR &instruction(DockerOp op, const std::string &keyword, const std::string &args) {
+        add(op, keyword, args);
+        return *this;
+    }
+    
+    DockerInstruction &last() { return stages.back().instructions.back(); }
+    
+    bool usesBuildKitFlags() const {
+        for (const auto &stage : stages)
+            for (const auto &instruction : stage.instructions)
+                for (const auto &flag : instruction.flags)
+                    if (flag.rfind("--mount=", 0) == 0 || flag.rfind("--network=", 0) == 0)
+                        return true;
+        return false;
+    }
+    
+    std::string render() const {
+        std::string out;
+        bool hasSyntax = false;
+        for (const auto &line : preamble)
+            hasSyntax = hasSyntax || line.rfind("# syntax=", 0) == 0;
+        if (!hasSyntax && usesBuildKitFlags())
+            out += "# syntax=docker/dockerfile:1\n";
+        for (const auto &line : preamble)
+            out += line + "\n";
+        for (size_t i = 0; i < stages.size(); ++i) {
+            const auto &stage = stages[i];
+            if (i > 0 || !stage.comment.empty())
+                out += "\n";
+            if (!stage.comment.empty())
+                out += "# " + stage.comment + "\n";
+            out += "FROM ";
+            for (const auto &flag : stage.fromFlags)
+                out += flag + " ";
+            out += stage.image + (stage.name.empty() ? "" : " AS " + stage.name) + "\n";
+            for (const auto &instruction : stage.instructions)
+                out += renderInstruction(instruction);
+        }
+        return out;
+    }
+    
+    static std::string renderInstruction(const DockerInstruction &instruction) {
+        if (instruction.op == DockerOp::Comment)
+            return "# " + instruction.args + "\n";
+        std::string line = instruction.keyword;
+        for (const auto &flag : instruction.flags)
+            line += " " + flag;
+        if (instruction.op == DockerOp::Run) {
+            for (size_t i = 0; i < instruction.commands.size(); ++i)
+                line += (i == 0 ? " " : " \\\n    && ") + instruction.commands[i];
+        } else if (!instruction.args.empty()) {
+            line += " " + instruction.args;
+        }
+        return line + "\n" + instruction.heredoc;
+    }
+    
+private:
+    DockerInstruction &add(DockerOp op, const std::string &keyword, const std::string &args) {
+        if (stages.empty())
+            throw std::logic_error(keyword + " before FROM");
+        stages.back().instructions.emplace_back();
+        DockerInstruction &instruction = stages.back().instructions.back();
+        instruction.op = op;
+        instruction.keyword = keyword;
+        instruction.args = args;
+        return instruction;
+    }
+};
+
+DockerOp dockerOpFor(const std::string &keyword) {
+    static const std::map<std::string, DockerOp> ops = {
+        {"RUN", DockerOp::Run}, {"COPY", DockerOp::Copy}, {"ENV", DockerOp::Env}, {"ARG", DockerOp::Arg},
+        {"WORKDIR", DockerOp::Workdir}, {"CMD", DockerOp::Cmd}, {"ENTRYPOINT", DockerOp::Entrypoint},
+        {"EXPOSE", DockerOp::Expose}, {"LABEL", DockerOp::Label}, {"USER", DockerOp::User}};
+    auto it = ops.find(keyword);
+    return it == ops.end() ? DockerOp::Other : it->second;
+}
+
+// Reads Dockerfile text back into the IR: comments, line continuations, instruction flags, heredocs
+// and multi-stage FROM lines. Instructions before the first FROM become preamble. Heredoc bodies are
+// kept verbatim on their instruction, which the passes then leave alone.
+DockerfileIR parseDockerfile(const std::string &text) {
+    static const std::regex heredocRegex("<<(-?)([\"']?)([A-Za-z_][A-Za-z0-9_]*)\\2");
+    DockerfileIR docker;
+    std::istringstream in(text);
+    std::string line, logical;
+    int lineNumber = 0, startLine = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        std::string stripped = trim(line);
+        if (logical.empty()) {
+            if (stripped.empty())
+                continue;
+            if (stripped[0] == '#') {
+                if (docker.stages.empty())
+                    docker.preamble.push_back(stripped);
+                else
+                    docker.comment(trim(stripped.substr(1)));
+                continue;
+            }
+            startLine = lineNumber;
+        } else if (!stripped.empty() && stripped[0] == '#') {
+            continue;
+        }
+        if (!stripped.empty() && stripped.back() == '\\') {
+            logical += stripped.substr(0, stripped.size() - 1) + " ";
+            continue;
+        }
+        logical += stripped;
+        
+        std::string heredoc;
+        for (std::sregex_iterator it(logical.begin(), logical.end(), heredocRegex), end; it != end; ++it) {
+            bool stripTabs = !(*it)[1].str().empty();
+            std::string delimiter = (*it)[3];
+            while (std::getline(in, line)) {
+                ++lineNumber;
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                heredoc += line + "\n";
+                std::string body = stripTabs ? line.substr(std::min(line.find_first_not_of('\t'), line.size())) : line;
+                if (body == delimiter)
+                    break;
+            }
+        }
+        
+        std::istringstream words(logical);
+        std::string keyword;
+        words >> keyword;
+        std::string upper = keyword;
+        for (auto &c : upper)
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        std::string rest = trim(logical.substr(keyword.size()));
+        std::vector<std::string> flags;
+        while (rest.rfind("--", 0) == 0) {
+            size_t end = rest.find_first_of(" \t");
+            flags.push_back(rest.substr(0, end));
+            rest = end == std::string::npos ? "" : trim(rest.substr(end));
+        }
+        if (upper == "FROM") {
+            auto parts = splitWords(rest);
+            DockerStage &stage = docker.from(parts.empty() ? "" : parts[0]);
+            stage.fromFlags = flags;
+            stage.line = startLine;
+            if (parts.size() >= 3 && lowercase(parts[1]) == "as")
+                stage.name = parts[2];
+        } else if (docker.stages.empty()) {
+            docker.preamble.push_back(logical);
+        } else {
+            // Exec-form and heredoc RUNs are not shell && chains, so they never take part in merging.
+            bool shellRun = upper == "RUN" && heredoc.empty() && rest.rfind("[", 0) != 0;
+            if (shellRun) {
+                docker.run(rest);
+            } else {
+                docker.instruction(upper == "RUN" ? DockerOp::Other : dockerOpFor(upper), upper, rest);
+                docker.last().heredoc = heredoc;
+            }
+            docker.last().flags = flags;
+            docker.last().line = startLine;
+        }
+        logical.clear();
+    }
+    return docker;
+}
+
+bool isWholeContextCopy(const DockerInstruction &instruction) {
+    if (instruction.op != DockerOp::Copy || !instruction.heredoc.empty())
+        return false;
+    for (const auto &flag : instruction.flags)
+        if (flag.rfind("--chown=", 0) != 0 && flag.rfind("--chmod=", 0) != 0 && flag != "--link")
+            return false;
+    auto words = splitWords(instruction.args);
+    return words.size() == 2 && (words[0] == "." || words[0] == "./");
+}
+
+// Moves dependency installs (RUNs with declared inputs) directly after a `COPY . <dest>` above it,
+// preceded by a COPY of just those inputs, so editing source code no longer invalidates them.
+void orderByVolatility(DockerStage &stage) {
+    auto &list = stage.instructions;
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (!isWholeContextCopy(list[i]))
+            continue;
+        size_t end = i + 1;
+        while (end < list.size() && list[end].op == DockerOp::Run && !list[end].inputs.empty())
+            ++end;
+        if (end == i + 1)
+            continue;
+        std::string dest = splitWords(list[i].args)[1];
+        if (dest.back() != '/')
+            dest += '/';
+        std::set<std::string> seen;
+        std::vector<std::string> topLevelFiles, nested;
+        for (size_t k = i + 1; k < end; ++k) {
+            for (const auto &input : list[k].inputs) {
+                if (!seen.insert(input).second)
+                    continue;
+                if (input.find('/') == std::string::npos)
+                    topLevelFiles.push_back(input);
+                else
+                    nested.push_back(input);
+            }
+        }
+        std::vector<DockerInstruction> hoisted;
+        auto copyOf = [&](const std::string &args) {
+            DockerInstruction copy;
+            copy.op = DockerOp::Copy;
+            copy.keyword = "COPY";
+            copy.flags = list[i].flags;
+            copy.args = args;
+            hoisted.push_back(copy);
+        };
+        if (!topLevelFiles.empty()) {
+            std::string args;
+            for (const auto &file : topLevelFiles)
+                args += file + " ";
+            copyOf(args + dest);
+        }
+        for (const auto &path : nested) {
+            std::string clean = path.back() == '/' ? path.substr(0, path.size() - 1) : path;
+            copyOf(clean + " " + dest + clean);
+        }
+        for (size_t k = i + 1; k < end; ++k)
+            hoisted.push_back(std::move(list[k]));
+        DockerInstruction wholeCopy = std::move(list[i]);
+        list.erase(list.begin() + static_cast<std::ptrdiff_t>(i), list.begin() + static_cast<std::ptrdiff_t>(end));
+        hoisted.push_back(std::move(wholeCopy));
+        list.insert(list.begin() + static_cast<std::ptrdiff_t>(i), hoisted.begin(), hoisted.end());
+        i += hoisted.size() - 1;
+    }
+    
+    // LABEL and EXPOSE never affect a RUN, so they can sit right after FROM where they cost no rebuilds.
+    // One that expands a variable stays below the ARG/ENV defining it.
+    std::stable_partition(list.begin(), list.end(), [](const DockerInstruction &instruction) {
+        return (instruction.op == DockerOp::Label || instruction.op == DockerOp::Expose) &&
+               instruction.args.find('$') == std::string::npos;
+    });
+}
+
+bool commandChangesShellState(const std::string &command) {
+    static const std::regex stateful("(^|[;&|(]\\s*)(cd|export|source|\\.|set|unset|umask|alias)\\s");
+    return std::regex_search(command, stateful);
+}
+
+// Adjacent RUNs with identical flags become one layer. A command that changes shell state (cd,
+// export, ...) is wrapped in a subshell so it cannot leak into the commands merged after it.
+void mergeAdjacentRuns(DockerStage &stage) {
+    auto isolate = [](std::vector<std::string> &commands) {
+        bool stateful = false;
+        for (const auto &command : commands)
+            stateful = stateful || commandChangesShellState(command);
+        if (!stateful)
+            return;
+        std::string group;
+        for (const auto &command : commands)
+            group += (group.empty() ? "(" : " && ") + command;
+        commands = {group + ")"};
+    };
+    auto &list = stage.instructions;
+    bool currentMerged = false;
+    for (size_t i = 0; i + 1 < list.size();) {
+        DockerInstruction &current = list[i];
+        DockerInstruction &next = list[i + 1];
+        if (current.op != DockerOp::Run || next.op != DockerOp::Run || current.flags != next.flags) {
+            ++i;
+            currentMerged = false;
+            continue;
+        }
+        if (!currentMerged)
+            isolate(current.commands);
+        isolate(next.commands);
+        currentMerged = true;
+        current.commands.insert(current.commands.end(), next.commands.begin(), next.commands.end());
+        current.inputs.insert(current.inputs.end(), next.inputs.begin(), next.inputs.end());
+        list.erase(list.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+    }
+}
+
+// Every apt-get install runs after an update in the same layer and the package lists are removed in
+// that layer too; a separate cleanup RUN would leave the lists in the image.
+void aptCleanupSameLayer(DockerStage &stage) {
+    for (auto &instruction : stage.instructions) {
+        if (instruction.op != DockerOp::Run)
+            continue;
+        auto &commands = instruction.commands;
+        bool installs = false, updated = false, cleaned = false;
+        for (auto &command : commands) {
+            if (command.find("apt-get install") != std::string::npos) {
+                installs = true;
+                if (command.find("--no-install-recommends") == std::string::npos)
+                    command.replace(command.find("apt-get install"), 15, "apt-get install --no-install-recommends");
+                if (command.find(" -y") == std::string::npos && command.find(" --yes") == std::string::npos)
+                    command.replace(command.find("apt-get install"), 15, "apt-get install -y");
+            }
+            if (command.find("apt-get update") != std::string::npos && !installs)
+                updated = true;
+            if (command.find("/var/lib/apt/lists") != std::string::npos)
+                cleaned = true;
+        }
+        if (!installs)
+            continue;
+        if (!updated)
+            commands.insert(commands.begin(), "apt-get update");
+        if (!cleaned)
+            commands.push_back("rm -rf /var/lib/apt/lists/*");
+    }
+}
+
+std::string envKey(const std::string &assignment) {
+    size_t eq = assignment.find('=');
+    return eq == std::string::npos ? assignment : assignment.substr(0, eq);
+}
+
+// Identical assignments are dropped, and consecutive ENVs collapse into one instruction. An assignment
+// that expands a variable is left alone: one ENV substitutes the values from before it, so merging
+// `ENV A=/srv` and `ENV B=$A/data` changes B, and `ENV PATH=/x:$PATH` twice is not a repeat.
+void dedupeEnv(DockerStage &stage) {
+    std::map<std::string, std::string> current;
+    std::vector<DockerInstruction> result;
+    for (auto &instruction : stage.instructions) {
+        if (instruction.op != DockerOp::Env || instruction.args.find('=') == std::string::npos ||
+            instruction.args.find_first_of("\"'\\") != std::string::npos) {
+            result.push_back(std::move(instruction));
+            continue;
+        }
+        std::string kept;
+        for (const auto &assignment : splitWords(instruction.args)) {
+            std::string key = envKey(assignment);
+            auto it = current.find(key);
+            if (it != current.end() && it->second == assignment && assignment.find('$') == std::string::npos)
+                continue;
+            current[key] = assignment;
+            kept += (kept.empty() ? "" : " ") + assignment;
+        }
+        if (kept.empty())
+            continue;
+        if (!result.empty() && result.back().op == DockerOp::Env && result.back().flags.empty() &&
+            kept.find('$') == std::string::npos && result.back().args.find('$') == std::string::npos) {
+            result.back().args += " " + kept;
+        } else {
+            instruction.args = kept;
+            result.push_back(std::move(instruction));
+        }
+    }
+    stage.instructions = std::move(result);
+}
+
+struct CacheMountRule {
+    const char *pattern;
+    const char *targets;
+};
+
+// Package-manager caches. Most sit outside the installed result; /go/pkg/mod and the cargo registry are
+// the module stores later RUNs build from, so they are only present while a mounted RUN runs and are
+// missing from the image (and from stages built FROM it) unless a step copies what it needs out.
+const CacheMountRule cacheMountRules[] = {
+    {"pip (install|wheel|download)", "/root/.cache/pip"},
+    {"npm (ci|install)", "/root/.npm"},
+    {"yarn( install|$| --)", "/usr/local/share/.cache/yarn"},
+    {"pnpm (install|fetch)", "/root/.local/share/pnpm/store"},
+    {"\\bgo (mod download|build|test)", "/go/pkg/mod /root/.cache/go-build"},
+    {"cargo (build|fetch|test)", "/usr/local/cargo/registry /usr/local/cargo/git"},
+    {"mvn ", "/root/.m2"},
+    {"gradle ", "/root/.gradle"},
+    {"composer (install|require)", "/root/.composer/cache"},
+    {"apt-get install", "/var/cache/apt"},
+};
+
+void addCacheMounts(DockerStage &stage) {
+    for (auto &instruction : stage.instructions) {
+        if (instruction.op != DockerOp::Run)
+            continue;
+        std::set<std::string> targets;
+        bool apt = false;
+        for (const auto &command : instruction.commands) {
+            for (const auto &rule : cacheMountRules) {
+                if (std::regex_search(command, std::regex(rule.pattern))) {
+                    splitInto(targets, rule.targets);
+                    apt = apt || std::string(rule.targets) == "/var/cache/apt";
+                }
+            }
+        }
+        for (const auto &flag : instruction.flags) {
+            std::string::size_type target = flag.find("target=");
+            if (flag.rfind("--mount=", 0) == 0 && target != std::string::npos)
+                targets.erase(flag.substr(target + 7, flag.find(',', target) - target - 7));
+        }
+        for (const auto &target : targets) {
+            std::string flag = "--mount=type=cache,target=" + target;
+            if (target == "/var/cache/apt")
+                flag += ",sharing=locked";
+            instruction.flags.push_back(flag);
+        }
+        // Debian images delete downloaded .debs after every install; keep them for the cache mount.
+        if (apt)
+            instruction.commands.insert(instruction.commands.begin(), "rm -f /etc/apt/apt.conf.d/docker-clean");
+    }
+}
+
+void optimizeDockerfile(DockerfileIR &docker) {
+    // A dev image is used as is, so what its installs download (go modules, crates) has to stay in it.
+    static const std::regex devStage("(.*-)?dev");
+    for (auto &stage : docker.stages) {
+        orderByVolatility(stage);
+        aptCleanupSameLayer(stage);
+        mergeAdjacentRuns(stage);
+        dedupeEnv(stage);
+        if (!std::regex_match(stage.name, devStage))
+            addCacheMounts(stage);
+    }
+}
+
+class LanguageHandler {
+public:
+    virtual bool detect(const std::string &folderPath) = 0;
+    virtual std::set<std::string> extractDependencies(const std::string &folderPath) = 0;
+    virtual void emitDockerfile(DockerfileIR &docker, const std::string &folderPath,
+                                const std::set<std::string> &deps) = 0;
+    virtual std::string getName() const = 0;
+    // Adds a `test` stage when the project has tests; it is only built with `--target test`.
+    virtual void emitTestStage(DockerfileIR &docker, const std::string &folderPath) {}
+    // Fills a single-stage `dev` image (dependencies and the language's reloader, no sources) and the
+    // compose service that bind-mounts the project into it. Returns false when there is none.
+    virtual bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) { return false; }
+    // Manifests and source extensions; the event stream derives the detection score and dependency provenance from them.
+    virtual std::vector<std::string> manifestNames() const { return {}; }
+    virtual std::vector<std::string> sourceExtensions() const { return {}; }
+    virtual ~LanguageHandler() {}
+};
+
+// Share of the project's files that are this language's sources or manifests; -1 when the handler does not say.
+double detectionScore(const LanguageHandler &handler, const std::string &folderPath) {
+    auto extensions = handler.sourceExtensions();
+    const ProjectIndex &index = projectIndex(folderPath);
+    if (extensions.empty() || index.fileCount() == 0)
+        return -1;
+    size_t matched = 0;
+    for (const auto &extension : extensions)
+        matched += index.filesWithExtension(extension).size();
+    for (const auto &manifest : handler.manifestNames()) {
+        std::string extension = fs::path(manifest).extension().string();
+        if (fileExistsInFolder(folderPath, manifest) &&
+            std::find(extensions.begin(), extensions.end(), extension) == extensions.end())
+            ++matched;
+    }
+    return std::min(1.0, static_cast<double>(matched) / index.fileCount());
+}
+
+// Where `dependency` appears in a manifest as a whole name (`express` not inside `express-session`,
+// `os` not inside `pos`), or npos.
+size_t findDependencyName(const std::string &text, const std::string &dependency) {
+    auto nameChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || (c && std::strchr("-_./@", c)); };
+    for (size_t at = text.find(dependency); at != std::string::npos; at = text.find(dependency, at + 1)) {
+        size_t end = at + dependency.size();
+        if ((at == 0 || !nameChar(text[at - 1])) && (end == text.size() || !nameChar(text[end])))
+            return at;
+    }
+    return std::string::npos;
+}
+
+// The first manifest that names the dependency, or "imports" when it only came from scanning the sources.
+std::string dependencySource(const LanguageHandler &handler, const std::string &folderPath, const std::string &dependency) {
+    for (const auto &manifest : handler.manifestNames()) {
+        fs::path path = fs::path(folderPath) / manifest;
+        if (fs::is_regular_file(path) && findDependencyName(projectIndex(folderPath).contents(path), dependency) != std::string::npos)
+            return manifest;
+    }
+    return "imports";
+}
+
+// The version written next to the dependency in its manifest (`flask==2.0.1`, `"express": "^4.18.2"`,
+// `serde = { version = "1.0" }`, `gem 'rails', '~> 7.0'`), or "" when that line has none.
+std::string dependencyVersion(const LanguageHandler &handler, const std::string &folderPath, const std::string &dependency) {
+    static const std::regex version(R"(^[^0-9\n]*?(\d+(?:\.[0-9A-Za-z*+-]+)*))");
+    for (const auto &manifest : handler.manifestNames()) {
+        fs::path path = fs::path(folderPath) / manifest;
+        if (!fs::is_regular_file(path))
+            continue;
+        const std::string &text = projectIndex(folderPath).contents(path);
+        size_t at = findDependencyName(text, dependency);
+        if (at == std::string::npos)
+            continue;
+        size_t end = at + dependency.size();
+        std::string rest = text.substr(end, text.find('\n', end) - end);
+        std::smatch match;
+        return std::regex_search(rest, match, version) ? match[1].str() : "";
+    }
+    return "";
+}
+
+// The test stage starts from the stage holding the sources and dependencies, so BuildKit runs it next to
+// the runtime stage instead of before it. It goes in front of the runtime stage, which stays the default
+// target; testing the final stage itself names it and re-exports it with a trailing FROM instead.
+void addTestStage(DockerfileIR &docker, const std::string &command, const std::string &sourceStage = "") {
+    std::string from = sourceStage;
+    bool finalStage = from.empty();
+    if (finalStage) {
+        if (docker.stages.back().name.empty())
+            docker.stages.back().name = "app";
+        from = docker.stages.back().name;
+    }
+    docker.from(from, "test");
+    docker.run(command);
+    if (finalStage)
+        docker.from(from);
+    else
+        std::rotate(docker.stages.end() - 2, docker.stages.end() - 1, docker.stages.end());
+}
+
+bool hasStage(const DockerfileIR &docker, const std::string &name) {
+    for (const auto &stage : docker.stages)
+        if (stage.name == name)
+            return true;
+    return false;
+}
+
+// Manifests that pull in other files from the context (editable installs, local paths, workspaces,
+// install scripts) cannot be installed from a narrow COPY, so their installs are not reordered.
+bool fileMentions(const std::string &folderPath, const std::string &name, const std::regex &pattern) {
+    std::ifstream file(fs::path(folderPath) / name);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return std::regex_search(content, pattern);
+}
+
+std::vector<std::string> existingFiles(const std::string &folderPath, const std::vector<std::string> &names) {
+    std::vector<std::string> found;
+    for (const auto &name : names)
+        if (fileExistsInFolder(folderPath, name))
+            found.push_back(name);
+    return found;
+}
+
+std::vector<std::string> pythonInstallInputs(const std::string &folderPath, bool offline,
+                                             const std::string &requirements = "requirements.txt") {
+    static const std::regex local("(^|\\n)\\s*(-e|--editable|-r|--requirement|-c|--constraint|\\.|/)|file:");
+    if (!fileExistsInFolder(folderPath, requirements) || fileMentions(folderPath, requirements, local))
+        return {};
+    std::vector<std::string> inputs = {requirements};
+    if (offline)
+        inputs.push_back(vendorDir + "/wheelhouse/");
+    return inputs;
+}
+
+std::vector<std::string> nodeInstallInputs(const std::string &folderPath, const std::string &vendored) {
+    static const std::regex local("\"(file|link|workspace|portal):|\"workspaces\"|\"(preinstall|install|postinstall|prepare)\"\\s*:");
+    if (!fileExistsInFolder(folderPath, "package.json") || fileMentions(folderPath, "package.json", local))
+        return {};
+    auto inputs = existingFiles(folderPath, {"package.json", "package-lock.json", "npm-shrinkwrap.json",
+                                             "yarn.lock", "pnpm-lock.yaml", ".npmrc", ".yarnrc.yml"});
+    if (!vendored.empty())
+        inputs.push_back(vendorDir + "/" + vendored + "/");
+    return inputs;
+}
+
+std::vector<std::string> goModInputs(const std::string &folderPath) {
+    if (!fileExistsInFolder(folderPath, "go.mod") || fileMentions(folderPath, "go.mod", std::regex("=>\\s*(\\.|/)")))
+        return {};
+    return existingFiles(folderPath, {"go.mod", "go.sum"});
+}
+
+std::vector<std::string> gemfileInputs(const std::string &folderPath) {
+    static const std::regex local("(^|\\n)\\s*gemspec|path:|:path\\s*=>|(^|\\n)\\s*path\\s");
+    if (!fileExistsInFolder(folderPath, "Gemfile") || fileMentions(folderPath, "Gemfile", local))
+        return {};
+    return existingFiles(folderPath, {"Gemfile", "Gemfile.lock"});
+}
+
+std::vector<std::string> composerInputs(const std::string &folderPath) {
+    static const std::regex local("\"(path|artifact)\"|\"(pre|post)-(install|update)-cmd\"");
+    if (!fileExistsInFolder(folderPath, "composer.json") || fileMentions(folderPath, "composer.json", local))
+        return {};
+    return existingFiles(folderPath, {"composer.json", "composer.lock", "auth.json"});
+}
+
+// With --platforms the compiled languages build on the native $BUILDPLATFORM and cross-compile to
+// $TARGETPLATFORM; only the small runtime stage is pulled per architecture, so nothing runs under QEMU.
+bool crossCompiling() {
+    return !operatorOptions.platforms.empty();
+}
+
+// C and C++ cross toolchains (xx-clang, xx-cargo, xx-apt-get) for Debian-based builders.
+const std::string crossToolsImage = "tonistiigi/xx:1.4.0";
+
+DockerStage &crossBuilder(DockerfileIR &docker, const std::string &image, const std::string &name) {
+    DockerStage &stage = docker.from(image, name);
+    stage.fromFlags.push_back("--platform=$BUILDPLATFORM");
+    return stage;
+}
+
+std::string firstMatch(const std::string &content, const std::regex &pattern, const std::string &fallback) {
+    std::smatch match;
+    return std::regex_search(content, match, pattern) ? match[1].str() : fallback;
+}
+
+std::string cargoPackageName(const std::string &folderPath) {
+    std::ifstream file(fs::path(folderPath) / "Cargo.toml");
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    static const std::regex nameRegex("\\[package\\][^\\[]*?\\bname\\s*=\\s*\"([^\"]+)\"");
+    return firstMatch(content, nameRegex, "app");
+}
+
+fs::path findProjectFile(const std::string &folderPath) {
+    fs::path shallowest;
+    for (const auto &file : projectIndex(folderPath).filesWithExtension(".csproj"))
+        if (shallowest.empty() || std::distance(file.begin(), file.end()) < std::distance(shallowest.begin(), shallowest.end()))
+            shallowest = file;
+    return shallowest;
+}
+
+// Sets $linker to the fastest linker the builder image has (mold, then lld), or leaves the default.
+const std::string fastLinkerProbe = "linker=; if command -v mold >/dev/null 2>&1; then linker=-fuse-ld=mold; "
+                                    "elif command -v ld.lld >/dev/null 2>&1; then linker=-fuse-ld=lld; fi";
+
+// Moves debug info of a release binary to /debug (exported by the `debug` stage) and leaves a
+// stripped binary with a debuglink, so debuggers still find the symbols.
+std::string splitDebugInfo(const std::string &binary) {
+    std::string debugFile = "/debug/" + fs::path(binary).filename().string() + ".debug";
+    return "mkdir -p /debug && objcopy --only-keep-debug " + binary + " " + debugFile +
+           " && objcopy --strip-debug --strip-unneeded " + binary + " && objcopy --add-gnu-debuglink=" + debugFile + " " + binary;
+}
+
+void emitDebugStage(DockerfileIR &docker, const std::string &builder) {
+    docker.from("scratch", "debug");
+    docker.copyFrom(builder, "/debug /");
+}
+
+// Profile-guided builds: --pgo=<training command> runs the instrumented binary ($PGO_BINARY) inside the
+// build and feeds the merged profile to an LTO rebuild. A profile committed at pgoProfile is used as is,
+// so CI skips the instrumented build and training; `--target pgo-profile --output .operator/pgo` exports one.
+const std::string pgoProfile = ".operator/pgo/merged.profdata";
+
+bool pgoEnabled(const std::string &folderPath) {
+    if (operatorOptions.pgoTraining.empty() && !fileExistsInFolder(folderPath, pgoProfile))
+        return false;
+    if (crossCompiling() || operatorOptions.offline) {
+        std::cerr << "PGO 빌드는 --platforms/--offline과 함께 사용할 수 없어 일반 빌드로 생성합니다.\n";
+        return false;
+    }
+    return true;
+}
+
+// --compile-cache=local keeps ccache/sccache objects in a BuildKit cache mount; --compile-cache=<http url>
+// additionally shares them through an HTTP/WebDAV server (`operator cache-server` is enough for a local one).
+bool compileCacheEnabled() {
+    if (operatorOptions.compileCache.empty())
+        return false;
+    if (operatorOptions.offline) {
+        std::cerr << "컴파일 캐시는 --offline과 함께 사용할 수 없어 생략합니다.\n";
+        return false;
+    }
+    return true;
+}
+
+std::string compileCacheServer(const std::string &tool) {
+    std::string url = operatorOptions.compileCache;
+    if (url == "local")
+        return "";
+    while (!url.empty() && url.back() == '/')
+        url.pop_back();
+    return url + "/" + tool;
+}
+
+const std::string sccacheVersion = "v0.8.2";
+
+// Runs a compile step (after the linker probe) with the cache directory mounted; the counters are zeroed
+// first and the hit statistics end up in the build log.
+void compileCacheRun(DockerfileIR &docker, const std::string &tool, const std::string &cacheDir, const std::string &command) {
+    docker.run(fastLinkerProbe + " && " + tool + " --zero-stats && " + command + " && " + tool + " --show-stats");
+    docker.last().flags.push_back("--mount=type=cache,target=" + cacheDir);
+}
+
+bool hasPythonTests(const std::string &folderPath) {
+    static const std::regex testFile("(test_.*|.*_test)\\.py");
+    bool tests = fileExistsInFolder(folderPath, "tests");
+    for (const auto &file : projectIndex(folderPath).filesWithExtension(".py"))
+        tests = tests || std::regex_match(file.filename().string(), testFile);
+    return tests;
+}
+
+class PythonHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "Python"; }
+    std::vector<std::string> sourceExtensions() const override { return {".py"}; }
+    std::vector<std::string> manifestNames() const override { return {"requirements.txt", "pyproject.toml", "setup.py", "Pipfile"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "requirements.txt"))
+            return true;
+        if (fileWithExtensionExists(folderPath, ".py"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        static const PatternSet imports({"^\\s*(?:import|from)\\s+([a-zA-Z0-9_]+)"});
+        return scanImports(folderPath, {".py"}, imports);
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        bool hasRequirements = fileExistsInFolder(folderPath, "requirements.txt");
+        auto plan = planNativeBuild(pythonNativeRequirements, hasRequirements ? readRequirementNames(folderPath) : deps);
+        bool offline = hasRequirements && useVendorCache(folderPath, "wheelhouse");
+        if (!plan.empty())
+            return emitNativeDockerfile(docker, folderPath, hasRequirements, offline, deps, plan);
+        
+        docker.from("python:3.9");
+        docker.workdir("/app");
+        if (!hasRequirements && !deps.empty())
+            docker.run("pip install --upgrade pip").run("pip install " + joinWords(deps));
+        docker.copy(". /app");
+        auto inputs = pythonInstallInputs(folderPath, offline);
+        if (offline)
+            docker.offlineRun("pip install --no-index --find-links=/app/" + vendorDir + "/wheelhouse -r requirements.txt", inputs);
+        else if (hasRequirements)
+            docker.run("pip install --upgrade pip", inputs).run("pip install -r requirements.txt", inputs);
+        docker.cmd({"python", "main.py"});
+    }
+    
+private:
+    void emitNativeDockerfile(DockerfileIR &docker, const std::string &folderPath, bool hasRequirements, bool offline,
+                              const std::set<std::string> &deps, const NativeBuildPlan &plan) {
+        // Offline builds cannot reach apt mirrors; the full python image already ships the toolchain and -dev headers.
+        docker.from("python:3.9", "python-builder");
+        if (!plan.buildPackages.empty() && !offline)
+            docker.run(aptInstall(plan.buildPackages));
+        docker.workdir("/app");
+        if (hasRequirements) {
+            auto inputs = pythonInstallInputs(folderPath, offline);
+            docker.copy(". /app");
+            for (const auto &sub : plan.binarySubstitutions)
+                if (!offline)
+                    docker.run("sed -i -E 's/^" + sub.first + "([^A-Za-z0-9._-]|$)/" + sub.second + "\\1/I' requirements.txt", inputs);
+            if (offline)
+                docker.offlineRun("pip wheel --no-index --find-links=/app/" + vendorDir + "/wheelhouse --wheel-dir /wheels -r requirements.txt", inputs);
+            else
+                docker.run("pip install --upgrade pip", inputs).run("pip wheel --prefer-binary --wheel-dir /wheels -r requirements.txt", inputs);
+        } else {
+            std::set<std::string> names;
+            for (const auto &dep : deps) {
+                std::string name = dep;
+                for (const auto &sub : plan.binarySubstitutions)
+                    if (sub.first == dep)
+                        name = sub.second;
+                names.insert(name);
+            }
+            docker.run("pip install --upgrade pip").run("pip wheel --prefer-binary --wheel-dir /wheels " + joinWords(names));
+        }
+        
+        if (offline && !plan.runtimePackages.empty()) {
+            docker.from("python:3.9");
+        } else {
+            docker.from("python:3.9-slim");
+            if (!plan.runtimePackages.empty())
+                docker.run(aptInstall(plan.runtimePackages));
+        }
+        docker.workdir("/app");
+        docker.copyFrom("python-builder", "/wheels /wheels");
+        docker.offlineRun("pip install --no-index --find-links=/wheels /wheels/*.whl && rm -rf /wheels");
+        docker.copy(". /app");
+        docker.cmd({"python", "main.py"});
+    }
+    
+public:
+    // A native build's runtime stage is slim and has no wheelhouse, so its tests run in the builder
+    // after installing the wheels built there. --offline installs pytest from the vendored wheelhouse.
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        if (!hasPythonTests(folderPath))
+            return;
+        bool hasRequirements = fileExistsInFolder(folderPath, "requirements.txt");
+        bool pytest = hasRequirements && readRequirementNames(folderPath).count("pytest");
+        std::string install = useVendorCache(folderPath, "wheelhouse")
+                                  ? "pip install --no-index --find-links=/app/" + vendorDir + "/wheelhouse pytest"
+                                  : "pip install pytest";
+        std::string command = pytest ? "python -m pytest" : install + " && python -m pytest";
+        if (hasStage(docker, "python-builder"))
+            addTestStage(docker, "pip install --no-index --find-links=/wheels /wheels/*.whl && " + command, "python-builder");
+        else
+            addTestStage(docker, command);
+    }
+    
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        bool hasRequirements = fileExistsInFolder(folderPath, "requirements.txt");
+        auto names = hasRequirements ? readRequirementNames(folderPath) : extractDependencies(folderPath);
+        dev.from("python:3.9");
+        dev.workdir("/app");
+        if (hasRequirements)
+            dev.copy("requirements.txt /app/").run("pip install -r requirements.txt");
+        if (fileExistsInFolder(folderPath, "manage.py")) {
+            dev.cmd({"python", "manage.py", "runserver", "0.0.0.0:8000"});
+            service.ports = {"8000:8000"};
+        } else if (names.count("fastapi")) {
+            dev.run("pip install uvicorn");
+            dev.cmd({"uvicorn", "main:app", "--reload", "--host", "0.0.0.0", "--port", "8000"});
+            service.ports = {"8000:8000"};
+        } else if (names.count("flask")) {
+            dev.cmd({"flask", "--app", "main", "run", "--debug", "--host", "0.0.0.0", "--port", "5000"});
+            service.ports = {"5000:5000"};
+        } else {
+            dev.run("pip install watchfiles");
+            dev.cmd({"watchfiles", "python main.py", "."});
+        }
+        return true;
+    }
+};
+
+// Minimal order-preserving JSON for package manifests and package-lock.json. Strings are kept
+// escaped exactly as read, so an untouched value is written back byte for byte.
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    Type type = Type::Null;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+    
+    const JsonValue *get(const std::string &key) const {
+        for (const auto &member : members)
+            if (member.first == key)
+                return &member.second;
+        return nullptr;
+    }
+    
+    void set(const std::string &key, JsonValue value) {
+        for (auto &member : members)
+            if (member.first == key) {
+                member.second = std::move(value);
+                return;
+            }
+        members.emplace_back(key, std::move(value));
+    }
+    
+    static JsonValue string(const std::string &text) {
+        JsonValue value;
+        value.type = Type::String;
+        value.text = text;
+        return value;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string &text) : text(text) {}
+    
+    bool parse(JsonValue &out) {
+        return value(out) && (skipSpace(), pos == text.size());
+    }
+    
+private:
+    const std::string &text;
+    size_t pos = 0;
+    
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+            ++pos;
+    }
+    
+    bool rawString(std::string &out) {
+        if (text[pos] != '"')
+            return false;
+        size_t start = ++pos;
+        while (pos < text.size() && text[pos] != '"')
+            pos += text[pos] == '\\' ? 2 : 1;
+        if (pos >= text.size())
+            return false;
+        out = text.substr(start, pos++ - start);
+        return true;
+    }
+    
+    bool value(JsonValue &out) {
+        skipSpace();
+        if (pos >= text.size())
+            return false;
+        char c = text[pos];
+        if (c == '"') {
+            out.type = JsonValue::Type::String;
+            return rawString(out.text);
+        }
+        if (c == '{' || c == '[') {
+            bool object = c == '{';
+            out.type = object ? JsonValue::Type::Object : JsonValue::Type::Array;
+            ++pos;
+            skipSpace();
+            if (pos < text.size() && text[pos] == (object ? '}' : ']'))
+                return ++pos, true;
+            while (true) {
+                skipSpace();
+                JsonValue item;
+                if (object) {
+                    std::string key;
+                    if (pos >= text.size() || !rawString(key))
+                        return false;
+                    skipSpace();
+                    if (pos >= text.size() || text[pos++] != ':' || !value(item))
+                        return false;
+                    out.members.emplace_back(key, std::move(item));
+                } else {
+                    if (!value(item))
+                        return false;
+                    out.items.push_back(std::move(item));
+                }
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') {
+                    ++pos;
+                    continue;
+                }
+                return pos < text.size() && text[pos++] == (object ? '}' : ']');
+            }
+        }
+        size_t start = pos;
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || std::strchr("+-.", text[pos])))
+            ++pos;
+        out.text = text.substr(start, pos - start);
+        if (out.text == "null")
+            out.type = JsonValue::Type::Null;
+        else if (out.text == "true" || out.text == "false")
+            out.type = JsonValue::Type::Bool;
+        else
+            out.type = JsonValue::Type::Number;
+        return !out.text.empty();
+    }
+};
+
+bool readJsonFile(const fs::path &path, JsonValue &out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return JsonParser(text).parse(out);
+}
+
+// Written the way npm writes package.json and package-lock.json (two-space indent).
+std::string renderJson(const JsonValue &value, const std::string &indent = "") {
+    using Type = JsonValue::Type;
+    if (value.type == Type::String)
+        return "\"" + value.text + "\"";
+    if (value.type != Type::Array && value.type != Type::Object)
+        return value.text;
+    bool object = value.type == Type::Object;
+    size_t count = object ? value.members.size() : value.items.size();
+    if (count == 0)
+        return object ? "{}" : "[]";
+    std::string inner = indent + "  ";
+    std::string json = object ? "{\n" : "[\n";
+    for (size_t i = 0; i < count; ++i) {
+        json += inner;
+        if (object)
+            json += "\"" + value.members[i].first + "\": " + renderJson(value.members[i].second, inner);
+        else
+            json += renderJson(value.items[i], inner);
+        json += i + 1 < count ? ",\n" : "\n";
+    }
+    return json + indent + (object ? "}" : "]");
+}
+
+const std::vector<std::string> nodeDependencyFields = {"dependencies", "devDependencies", "optionalDependencies", "peerDependencies"};
+
+// ---- Node workspaces ----
+// A service inside an npm/yarn/pnpm workspace is built from the workspace root with only the workspace
+// packages it depends on and a lockfile pruned to their dependencies, so unrelated packages neither
+// enlarge the install nor invalidate its layer.
+
+struct NodeWorkspace {
+    fs::path root;
+    std::string manager;
+    std::string lockfile;
+    fs::path service;
+    std::map<std::string, fs::path> packages;
+    std::vector<fs::path> included;
+    std::map<std::string, std::string> prunedFiles;
+};
+
+// Written on the FROM line of a workspace service's Dockerfile; context, fingerprint and estimate
+// read it back to know the build context is the workspace root rather than the service folder.
+const std::string workspaceContextMarker = "build context: workspace root";
+
+std::vector<std::string> workspacePatterns(const fs::path &root) {
+    std::vector<std::string> patterns;
+    JsonValue manifest;
+    if (readJsonFile(root / "package.json", manifest)) {
+        const JsonValue *workspaces = manifest.get("workspaces");
+        if (workspaces && workspaces->type == JsonValue::Type::Object)
+            workspaces = workspaces->get("packages");
+        if (workspaces)
+            for (const auto &item : workspaces->items)
+                patterns.push_back(item.text);
+    }
+    std::ifstream yaml(root / "pnpm-workspace.yaml");
+    static const std::regex entry("^\\s+-\\s*['\"]?([^'\"#]+?)['\"]?\\s*$");
+    bool inPackages = false;
+    std::smatch match;
+    for (std::string line; std::getline(yaml, line);) {
+        if (!line.empty() && !std::isspace(static_cast<unsigned char>(line[0])))
+            inPackages = line.rfind("packages:", 0) == 0;
+        else if (inPackages && std::regex_match(line, match, entry))
+            patterns.push_back(match[1]);
+    }
+    return patterns;
+}
+
+bool matchesWorkspacePattern(const std::string &directory, std::string pattern) {
+    while (pattern.size() > 1 && pattern.back() == '/')
+        pattern.pop_back();
+    if (pattern.rfind("./", 0) == 0)
+        pattern = pattern.substr(2);
+    std::string expression;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern.compare(i, 2, "**") == 0) {
+            expression += ".*";
+            ++i;
+        } else if (pattern[i] == '*') {
+            expression += "[^/]*";
+        } else {
+            if (std::strchr(".^$|()[]{}+?\\", pattern[i]))
+                expression += '\\';
+            expression += pattern[i];
+        }
+    }
+    return std::regex_match(directory, std::regex(expression));
+}
+
+std::map<std::string, fs::path> workspacePackages(const fs::path &root, const std::vector<std::string> &patterns) {
+    std::map<std::string, fs::path> packages;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+         it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (it->is_directory(ec) && (name == "node_modules" || name[0] == '.')) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (name != "package.json" || it->path().parent_path() == root)
+            continue;
+        std::string directory = it->path().parent_path().lexically_relative(root).generic_string();
+        bool included = false;
+        for (const auto &pattern : patterns) {
+            if (pattern[0] == '!' && matchesWorkspacePattern(directory, pattern.substr(1)))
+                included = false;
+            else if (pattern[0] != '!' && matchesWorkspacePattern(directory, pattern))
+                included = true;
+        }
+        JsonValue manifest;
+        const JsonValue *packageName;
+        if (included && readJsonFile(it->path(), manifest) && (packageName = manifest.get("name")))
+            packages[packageName->text] = directory;
+    }
+    return packages;
+}
+
+// Prunes a lockfileVersion 2/3 package-lock.json: keeps the entries reachable from the root and the
+// included workspaces, resolving every dependency the way Node does (nearest node_modules upwards).
+bool pruneNpmLockfile(const NodeWorkspace &workspace, const std::string &text, std::string &out) {
+    JsonValue lock;
+    JsonValue *packages = nullptr;
+    if (!JsonParser(text).parse(lock))
+        return false;
+    for (auto &member : lock.members)
+        if (member.first == "packages")
+            packages = &member.second;
+    if (!packages)
+        return false;
+    std::map<std::string, const JsonValue *> entries;
+    for (const auto &member : packages->members)
+        entries[member.first] = &member.second;
+    
+    std::set<std::string> kept;
+    std::vector<std::string> pending = {""};
+    for (const auto &package : workspace.packages)
+        if (std::find(workspace.included.begin(), workspace.included.end(), package.second) != workspace.included.end())
+            pending.insert(pending.end(), {package.second.generic_string(), "node_modules/" + package.first});
+    while (!pending.empty()) {
+        std::string key = pending.back();
+        pending.pop_back();
+        auto entry = entries.find(key);
+        if (entry == entries.end() || !kept.insert(key).second)
+            continue;
+        if (const JsonValue *resolved = entry->second->get("resolved"))
+            if (entry->second->get("link"))
+                pending.push_back(resolved->text);
+        bool installsDev = key.empty() || key.find("node_modules/") == std::string::npos;
+        for (const auto &field : nodeDependencyFields) {
+            const JsonValue *dependencies = entry->second->get(field);
+            if (!dependencies || (field == "devDependencies" && !installsDev))
+                continue;
+            for (const auto &dependency : dependencies->members) {
+                std::string directory = key;
+                while (true) {
+                    std::string candidate = (directory.empty() ? "" : directory + "/") + "node_modules/" + dependency.first;
+                    if (entries.count(candidate)) {
+                        pending.push_back(candidate);
+                        break;
+                    }
+                    if (directory.empty())
+                        break;
+                    std::string::size_type nested = directory.rfind("node_modules/");
+                    directory = nested == std::string::npos || nested == 0 ? "" : directory.substr(0, nested - 1);
+                }
+            }
+        }
+    }
+    
+    JsonValue pruned = *packages;
+    pruned.members.clear();
+    for (const auto &member : packages->members)
+        if (kept.count(member.first))
+            pruned.members.push_back(member);
+    JsonValue workspaces;
+    workspaces.type = JsonValue::Type::Array;
+    for (const auto &directory : workspace.included)
+        workspaces.items.push_back(JsonValue::string(directory.generic_string()));
+    for (auto &member : pruned.members)
+        if (member.first.empty() && member.second.get("workspaces"))
+            member.second.set("workspaces", workspaces);
+    lock.set("packages", pruned);
+    if (lock.get("dependencies"))
+        lock.members.erase(std::remove_if(lock.members.begin(), lock.members.end(),
+                                          [](const auto &member) { return member.first == "dependencies"; }),
+                           lock.members.end());
+    out = renderJson(lock) + "\n";
+    return true;
+}
+
+std::string unquote(std::string text) {
+    text = trim(text);
+    if (text.size() >= 2 && (text[0] == '"' || text[0] == '\'') && text.back() == text[0])
+        return text.substr(1, text.size() - 2);
+    return text;
+}
+
+// Yarn classic (v1) lockfiles: one block per resolved version, headed by every "name@range" it satisfies.
+bool pruneYarnLockfile(const NodeWorkspace &workspace, const std::vector<const JsonValue *> &manifests,
+                       const std::string &text, std::string &out) {
+    if (text.find("__metadata:") != std::string::npos)
+        return false;
+    std::vector<std::vector<std::string>> blocks;
+    std::string header;
+    std::istringstream in(text);
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line[0] != ' ' && line[0] != '#')
+            blocks.emplace_back();
+        if (blocks.empty() && !trim(line).empty())
+            header += line + "\n";
+        else if (!blocks.empty() && !trim(line).empty())
+            blocks.back().push_back(line);
+    }
+    std::map<std::string, size_t> specs;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        std::string heading = blocks[i][0].substr(0, blocks[i][0].rfind(':'));
+        std::istringstream list(heading);
+        for (std::string spec; std::getline(list, spec, ',');)
+            specs[unquote(spec)] = i;
+    }
+    
+    std::vector<std::string> pending;
+    for (const JsonValue *manifest : manifests)
+        for (const auto &field : nodeDependencyFields)
+            if (const JsonValue *dependencies = manifest->get(field))
+                for (const auto &dependency : dependencies->members)
+                    if (!workspace.packages.count(dependency.first))
+                        pending.push_back(dependency.first + "@" + dependency.second.text);
+    std::set<size_t> kept;
+    while (!pending.empty()) {
+        auto block = specs.find(pending.back());
+        pending.pop_back();
+        if (block == specs.end() || !kept.insert(block->second).second)
+            continue;
+        bool inDependencies = false;
+        for (const auto &line : blocks[block->second]) {
+            if (line.rfind("    ", 0) != 0) {
+                inDependencies = trim(line) == "dependencies:" || trim(line) == "optionalDependencies:";
+                continue;
+            }
+            if (!inDependencies)
+                continue;
+            std::string entry = trim(line);
+            std::string::size_type split = entry[0] == '"' ? entry.find('"', 1) + 1 : entry.find(' ');
+            pending.push_back(unquote(entry.substr(0, split)) + "@" + unquote(entry.substr(split)));
+        }
+    }
+    out = header;
+    for (size_t index : kept) {
+        out += "\n";
+        for (const auto &line : blocks[index])
+            out += line + "\n";
+    }
+    return true;
+}
+
+// pnpm lockfiles (v6 and v9): importers are filtered to the included workspaces, packages and
+// snapshots to what those importers reach. Everything else is copied as is.
+bool prunePnpmLockfile(const NodeWorkspace &workspace, const std::string &text, std::string &out) {
+    struct Section {
+        std::string heading;
+        std::vector<std::pair<std::string, std::vector<std::string>>> entries;
+    };
+    std::vector<Section> sections;
+    std::istringstream in(text);
+    for (std::string line; std::getline(in, line);) {
+        if (trim(line).empty())
+            continue;
+        if (line[0] != ' ') {
+            sections.push_back({line, {}});
+        } else if (!sections.empty() && line.rfind("  ", 0) == 0 && line[2] != ' ') {
+            std::string key = trim(line);
+            sections.back().entries.push_back({unquote(key.substr(0, key.rfind(':'))), {line}});
+        } else if (!sections.empty() && !sections.back().entries.empty()) {
+            sections.back().entries.back().second.push_back(line);
+        } else if (!sections.empty()) {
+            sections.back().heading += "\n" + line;
+        }
+    }
+    bool v6 = text.find("lockfileVersion: '6") != std::string::npos;
+    if (!v6 && text.find("lockfileVersion: '9") == std::string::npos)
+        return false;
+    
+    // Lines "name: version" (v6 and v9 snapshots) or "name:" followed by "version: ..." (importers).
+    auto dependencyKeys = [&](const std::vector<std::string> &lines, size_t depth) {
+        std::vector<std::string> keys;
+        std::string name;
+        bool inDependencies = false;
+        for (const auto &line : lines) {
+            size_t indent = line.find_first_not_of(' ');
+            std::string entry = trim(line);
+            std::string::size_type colon = entry.find(':');
+            if (indent == depth) {
+                std::string field = entry.substr(0, colon);
+                inDependencies = field == "dependencies" || field == "devDependencies" || field == "optionalDependencies";
+                continue;
+            }
+            if (!inDependencies || colon == std::string::npos)
+                continue;
+            std::string version;
+            if (indent == depth + 2) {
+                name = unquote(entry.substr(0, colon));
+                version = unquote(entry.substr(colon + 1));
+            } else if (indent == depth + 4 && entry.rfind("version:", 0) == 0) {
+                version = unquote(entry.substr(colon + 1));
+            }
+            if (version.empty() || version.rfind("link:", 0) == 0)
+                continue;
+            std::string base = version.substr(0, version.find('('));
+            if (version[0] == '/' || base.find('@') != std::string::npos)
+                keys.push_back(version);
+            else
+                keys.push_back((v6 ? "/" : "") + name + "@" + version);
+        }
+        return keys;
+    };
+    
+    std::set<std::string> importers = {"."};
+    for (const auto &directory : workspace.included)
+        importers.insert(directory.generic_string());
+    std::vector<std::string> pending;
+    for (auto &section : sections) {
+        if (section.heading != "importers:")
+            continue;
+        auto &entries = section.entries;
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const auto &entry) { return !importers.count(entry.first); }),
+                      entries.end());
+        for (const auto &entry : entries)
+            for (const auto &key : dependencyKeys(entry.second, 4))
+                pending.push_back(key);
+    }
+    Section *graph = nullptr;
+    for (auto &section : sections)
+        if (section.heading == (v6 ? "packages:" : "snapshots:"))
+            graph = &section;
+    std::set<std::string> kept;
+    std::map<std::string, const std::vector<std::string> *> nodes;
+    if (graph)
+        for (const auto &entry : graph->entries)
+            nodes[entry.first] = &entry.second;
+    while (!pending.empty()) {
+        std::string key = pending.back();
+        pending.pop_back();
+        if (!kept.insert(key).second || !nodes.count(key))
+            continue;
+        for (const auto &dependency : dependencyKeys(*nodes[key], 4))
+            pending.push_back(dependency);
+    }
+    std::set<std::string> keptBases;
+    for (const auto &key : kept)
+        keptBases.insert(key.substr(0, key.find('(')));
+    for (auto &section : sections) {
+        if (section.heading == "packages:" || section.heading == "snapshots:") {
+            const std::set<std::string> &keep = section.heading == "packages:" && !v6 ? keptBases : kept;
+            auto &entries = section.entries;
+            entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const auto &entry) { return !keep.count(entry.first); }),
+                          entries.end());
+        }
+    }
+    out.clear();
+    for (const auto &section : sections) {
+        bool spaced = section.heading == "importers:" || section.heading == "packages:" || section.heading == "snapshots:";
+        out += (out.empty() ? "" : "\n") + section.heading + "\n";
+        for (const auto &entry : section.entries) {
+            out += spaced ? "\n" : "";
+            for (const auto &line : entry.second)
+                out += line + "\n";
+        }
+    }
+    return true;
+}
+
+// Finds the workspace a project folder belongs to and computes its pruned manifest/lockfile pair.
+// Returns false (and the handler builds the folder on its own) when the folder is not a workspace
+// package or the lockfile format is not understood.
+fs::path findWorkspaceRoot(const fs::path &folder) {
+    for (fs::path root = folder.parent_path(); !root.empty(); root = root.parent_path()) {
+        if (!workspacePatterns(root).empty())
+            return root;
+        if (root == root.parent_path())
+            break;
+    }
+    return {};
+}
+
+fs::path absoluteFolder(const std::string &folderPath) {
+    fs::path folder = fs::absolute(folderPath).lexically_normal();
+    return folder.has_filename() ? folder : folder.parent_path();
+}
+
+bool planNodeWorkspace(const std::string &folderPath, NodeWorkspace &workspace) {
+    fs::path folder = absoluteFolder(folderPath);
+    workspace.root = findWorkspaceRoot(folder);
+    if (workspace.root.empty())
+        return false;
+    workspace.packages = workspacePackages(workspace.root, workspacePatterns(workspace.root));
+    workspace.service = folder.lexically_relative(workspace.root);
+    
+    std::map<fs::path, JsonValue> manifests;
+    std::map<std::string, fs::path> byDirectory;
+    for (const auto &package : workspace.packages)
+        byDirectory[package.second.generic_string()] = package.second;
+    if (!byDirectory.count(workspace.service.generic_string()))
+        return false;
+    std::vector<fs::path> pending = {workspace.service};
+    std::set<fs::path> included;
+    while (!pending.empty()) {
+        fs::path directory = pending.back();
+        pending.pop_back();
+        if (!included.insert(directory).second || !readJsonFile(workspace.root / directory / "package.json", manifests[directory]))
+            continue;
+        for (const auto &field : nodeDependencyFields)
+            if (const JsonValue *dependencies = manifests[directory].get(field))
+                for (const auto &dependency : dependencies->members)
+                    if (workspace.packages.count(dependency.first))
+                        pending.push_back(workspace.packages[dependency.first]);
+    }
+    workspace.included.assign(included.begin(), included.end());
+    
+    JsonValue root;
+    if (!readJsonFile(workspace.root / "package.json", root))
+        return false;
+    std::vector<const JsonValue *> allManifests = {&root};
+    for (const auto &manifest : manifests)
+        allManifests.push_back(&manifest.second);
+    
+    static const std::vector<std::pair<std::string, std::string>> lockfiles = {
+        {"pnpm-lock.yaml", "pnpm"}, {"yarn.lock", "yarn"}, {"package-lock.json", "npm"}};
+    workspace.manager = fs::exists(workspace.root / "pnpm-workspace.yaml") ? "pnpm" : "npm";
+    for (const auto &lockfile : lockfiles) {
+        std::ifstream in(workspace.root / lockfile.first, std::ios::binary);
+        if (!in)
+            continue;
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()), pruned;
+        bool ok = lockfile.second == "pnpm"   ? prunePnpmLockfile(workspace, text, pruned)
+                  : lockfile.second == "yarn" ? pruneYarnLockfile(workspace, allManifests, text, pruned)
+                                              : pruneNpmLockfile(workspace, text, pruned);
+        if (!ok) {
+            std::cerr << lockfile.first << " 형식을 해석할 수 없어 워크스페이스를 축소하지 않습니다.\n";
+            return false;
+        }
+        workspace.manager = lockfile.second;
+        workspace.lockfile = lockfile.first;
+        workspace.prunedFiles[lockfile.first] = pruned;
+        break;
+    }
+    
+    JsonValue directories;
+    directories.type = JsonValue::Type::Array;
+    for (const auto &directory : workspace.included)
+        directories.items.push_back(JsonValue::string(directory.generic_string()));
+    if (workspace.manager == "pnpm") {
+        // Other settings in pnpm-workspace.yaml (catalogs, onlyBuiltDependencies, ...) are kept.
+        std::string yaml = "packages:\n";
+        for (const auto &directory : workspace.included)
+            yaml += "  - '" + directory.generic_string() + "'\n";
+        std::ifstream original(workspace.root / "pnpm-workspace.yaml");
+        bool inPackages = false;
+        for (std::string line; std::getline(original, line);) {
+            if (!line.empty() && !std::isspace(static_cast<unsigned char>(line[0])))
+                inPackages = line.rfind("packages:", 0) == 0;
+            if (!inPackages)
+                yaml += line + "\n";
+        }
+        workspace.prunedFiles["pnpm-workspace.yaml"] = yaml;
+        root.members.erase(std::remove_if(root.members.begin(), root.members.end(),
+                                          [](const auto &member) { return member.first == "workspaces"; }),
+                           root.members.end());
+    } else {
+        root.set("workspaces", directories);
+    }
+    workspace.prunedFiles["package.json"] = renderJson(root) + "\n";
+    return true;
+}
+
+const std::string esbuildVersion = "0.24.0";
+
+class NodeHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "Node.js"; }
+    std::vector<std::string> sourceExtensions() const override { return {".js", ".mjs", ".cjs", ".ts", ".jsx", ".tsx"}; }
+    std::vector<std::string> manifestNames() const override { return {"package.json"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "package.json"))
+            return true;
+        if (fileWithExtensionExists(folderPath, ".js") || fileWithExtensionExists(folderPath, ".ts"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        static const PatternSet imports({"require\\(['\"]([^\\.][^'\"]*)['\"]\\)",
+                                         "import\\s+.*?['\"]([^\\.][^'\"]*)['\"]"});
+        return scanImports(folderPath, {".js", ".ts"}, imports);
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        bool hasPackageJson = fileExistsInFolder(folderPath, "package.json");
+        auto plan = planNativeBuild(nodeNativeRequirements, hasPackageJson ? readPackageJsonDependencies(folderPath) : deps);
+        workspaceBuild = false;
+        if (hasPackageJson && !operatorOptions.nodeStartup.empty())
+            return emitStartupDockerfile(docker, folderPath, plan);
+        if (!plan.empty())
+            return emitNativeDockerfile(docker, folderPath, hasPackageJson, deps, plan);
+        
+        NodeWorkspace workspace;
+        if (hasPackageJson && !operatorOptions.offline && planNodeWorkspace(folderPath, workspace)) {
+            workspaceBuild = true;
+            return emitWorkspaceDockerfile(docker, workspace);
+        }
+        
+        docker.from("node:14");
+        docker.workdir("/app");
+        if (!hasPackageJson && !deps.empty())
+            docker.run("npm install " + joinWords(deps));
+        docker.copy(". /app");
+        if (hasPackageJson)
+            emitInstall(docker, folderPath, "");
+        docker.cmd({"npm", "start"});
+    }
+    
+private:
+    bool workspaceBuild = false;
+    
+    std::string vendoredStore(const std::string &folderPath) {
+        if (fileExistsInFolder(folderPath, "pnpm-lock.yaml") && useVendorCache(folderPath, "pnpm-store"))
+            return "pnpm-store";
+        if (fileExistsInFolder(folderPath, "package-lock.json") && useVendorCache(folderPath, "npm-cache"))
+            return "npm-cache";
+        return "";
+    }
+    
+    void emitInstall(DockerfileIR &docker, const std::string &folderPath, const std::string &extraFlags) {
+        std::string cache = "/app/" + vendorDir;
+        std::string store = vendoredStore(folderPath);
+        auto inputs = nodeInstallInputs(folderPath, store);
+        if (store == "pnpm-store") {
+            if (!inputs.empty())
+                inputs.push_back(vendorDir + "/npm-cache/");
+            docker.offlineRun("npm install -g --offline --cache " + cache + "/npm-cache pnpm && pnpm install --offline --frozen-lockfile --store-dir " +
+                              cache + "/pnpm-store" + extraFlags, inputs);
+        } else if (store == "npm-cache") {
+            docker.offlineRun("npm ci --offline --cache " + cache + "/npm-cache" + extraFlags, inputs);
+        } else {
+            docker.run("npm install" + extraFlags, inputs);
+        }
+    }
+    
+    // Node version from engines.node, if it names one; the startup options need at least 22.
+    int nodeMajorVersion(const JsonValue &manifest) {
+        static const std::regex major("(\\d+)");
+        std::smatch match;
+        const JsonValue *engines = manifest.get("engines");
+        const JsonValue *node = engines ? engines->get("node") : nullptr;
+        return node && std::regex_search(node->text, match, major) ? std::stoi(match[1]) : 0;
+    }
+    
+    std::string nodeEntryPoint(const std::string &folderPath, const JsonValue &manifest) {
+        if (const JsonValue *main = manifest.get("main"))
+            return main->text;
+        static const std::regex startScript("\\bnode\\s+(?:--?[^\\s]+\\s+)*([^\\s]+\\.[cm]?[jt]s)");
+        std::smatch match;
+        const JsonValue *scripts = manifest.get("scripts");
+        const JsonValue *start = scripts ? scripts->get("start") : nullptr;
+        if (start && std::regex_search(start->text, match, startScript))
+            return match[1];
+        for (const char *candidate : {"index.js", "server.js", "app.js", "main.js", "src/index.js", "src/server.js"})
+            if (fileExistsInFolder(folderPath, candidate))
+                return candidate;
+        return "index.js";
+    }
+    
+    // --node-startup: bundle inlines the server and its dependencies into one file (esbuild), compile-cache
+    // warms NODE_COMPILE_CACHE in the final image, snapshot starts from a V8 startup snapshot of the bundle.
+    // The image runs node directly instead of going through npm start.
+    void emitStartupDockerfile(DockerfileIR &docker, const std::string &folderPath, const NativeBuildPlan &plan) {
+        JsonValue manifest;
+        readJsonFile(fs::path(folderPath) / "package.json", manifest);
+        auto &options = operatorOptions.nodeStartup;
+        int major = std::max(nodeMajorVersion(manifest), 22);
+        if (nodeMajorVersion(manifest) && nodeMajorVersion(manifest) < 22)
+            std::cerr << "engines.node가 22 미만이지만 --node-startup에는 Node 22 이상이 필요하여 node:22를 사용합니다.\n";
+        bool bundle = options.count("bundle") || options.count("snapshot");
+        if (bundle && operatorOptions.offline) {
+            std::cerr << "--offline에서는 esbuild를 받을 수 없어 번들/스냅샷을 생략합니다.\n";
+            bundle = false;
+        }
+        bool snapshot = bundle && options.count("snapshot");
+        // Native addons cannot be inlined; they stay in node_modules next to the bundle.
+        bool external = !plan.empty();
+        const JsonValue *type = manifest.get("type");
+        bool module = type && type->text == "module";
+        std::string entry = nodeEntryPoint(folderPath, manifest);
+        // --build-snapshot runs a single CommonJS script that may only require built-in modules.
+        if (snapshot && (module || fs::path(entry).extension() == ".mjs")) {
+            std::cerr << "ESM 진입점(" << entry << ")은 V8 스냅샷을 만들 수 없어 snapshot을 생략합니다.\n";
+            snapshot = false;
+        } else if (snapshot && external) {
+            std::cerr << "네이티브 애드온은 번들에서 제외되어 V8 스냅샷에서 불러올 수 없으므로 snapshot을 생략합니다.\n";
+            snapshot = false;
+        }
+        bool compileCache = options.count("compile-cache") && !snapshot;
+        std::string bundled = module ? "server.mjs" : "server.cjs";
+        std::string image = "node:" + std::to_string(major);
+        
+        docker.from(image, "node-builder");
+        if (!plan.buildPackages.empty() && !operatorOptions.offline)
+            docker.run(aptInstall(plan.buildPackages));
+        docker.workdir("/app");
+        docker.copy(". /app");
+        emitInstall(docker, folderPath, "");
+        if (bundle) {
+            docker.run("npx --yes esbuild@" + esbuildVersion + " " + entry + " --bundle --platform=node --target=node" + std::to_string(major) +
+                       " --format=" + (module ? "esm" : "cjs") + (external ? " --packages=external" : "") + " --outfile=dist/" + bundled);
+            // Pruned in its own stage: the test stage starts from node-builder and needs the devDependencies.
+            if (external) {
+                docker.from("node-builder", "node-production");
+                docker.run("npm prune --omit=dev");
+            }
+        }
+        
+        docker.from(image + "-slim");
+        if (!plan.runtimePackages.empty())
+            docker.run(aptInstall(plan.runtimePackages));
+        docker.workdir("/app");
+        docker.env("NODE_ENV", "production");
+        if (!bundle) {
+            docker.copyFrom("node-builder", "/app /app");
+        } else {
+            if (external)
+                docker.copyFrom("node-production", "/app/package.json /app/package.json").copyFrom("node-production", "/app/node_modules /app/node_modules");
+            docker.copyFrom("node-builder", "/app/dist/" + bundled + " /app/" + bundled);
+            entry = bundled;
+        }
+        if (snapshot) {
+            // The entry has to be snapshot-aware: v8.startupSnapshot.setDeserializeMainFunction starts the server.
+            docker.run("node --snapshot-blob snapshot.blob --build-snapshot " + entry);
+            docker.cmd({"node", "--snapshot-blob", "snapshot.blob"});
+            return;
+        }
+        if (compileCache) {
+            // Loads the app for a few seconds at its final path and flushes the compile cache; the cache is
+            // keyed by path and content, so it only helps when warmed in the runtime stage itself.
+            docker.env("NODE_COMPILE_CACHE", "/app/.node-compile-cache");
+            docker.run("timeout 30 node --import \"data:text/javascript,import m from 'node:module';"
+                       "setTimeout(()=>{m.flushCompileCache();process.exit(0)},5000).unref()\" " + entry + " || true");
+        }
+        docker.cmd({"node", entry});
+    }
+    
+    // Built from the workspace root: the pruned manifest/lockfile pair and the included packages'
+    // package.json files are installed first, then only the included package sources are copied.
+    void emitWorkspaceDockerfile(DockerfileIR &docker, const NodeWorkspace &workspace) {
+        std::string service = workspace.service.generic_string();
+        std::string slug = service;
+        std::replace_if(slug.begin(), slug.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '-');
+        std::string prune = ".operator/prune/" + slug;
+        for (const auto &file : workspace.prunedFiles)
+            docker.generatedFiles[(workspace.root / prune / file.first).string()] = file.second;
+        
+        // npm 6 (node:14) understands neither workspaces nor lockfile v2/v3, so workspace builds use a current LTS.
+        docker.from("node:20").comment = workspaceContextMarker + " (docker build -f " + service + "/Dockerfile .)";
+        docker.workdir("/app");
+        docker.copy(prune + "/ ./");
+        for (const auto &config : existingFiles(workspace.root.string(), {".npmrc", ".yarnrc", ".yarnrc.yml"}))
+            docker.copy(config + " ./");
+        for (const auto &directory : workspace.included)
+            docker.copy((directory / "package.json").generic_string() + " " + (directory / "package.json").generic_string());
+        bool locked = !workspace.lockfile.empty();
+        // corepack honours a "packageManager" pin; otherwise pnpm is matched to the lockfile format
+        // (lockfile v6 is written by pnpm 8, v9 by pnpm 9).
+        bool pinned = workspace.prunedFiles.at("package.json").find("\"packageManager\"") != std::string::npos;
+        if (workspace.manager == "pnpm") {
+            std::string pnpm = "pnpm@9";
+            if (locked && workspace.prunedFiles.at(workspace.lockfile).find("lockfileVersion: '6") != std::string::npos)
+                pnpm = "pnpm@8";
+            docker.run("corepack enable" + (pinned ? std::string() : " && corepack prepare " + pnpm + " --activate") +
+                       " && pnpm install" + (locked ? " --frozen-lockfile" : ""));
+        } else if (workspace.manager == "yarn")
+            docker.run(std::string(pinned ? "corepack enable && " : "") + (locked ? "yarn install --frozen-lockfile" : "yarn install"));
+        else
+            docker.run(locked ? "npm ci" : "npm install");
+        
+        // Shared root configuration (tsconfig.base.json, babel.config.js, ...) is usually needed to build a package.
+        static const std::regex rootConfig("[^.].*\\.(json|js|cjs|mjs|ts)");
+        std::set<std::string> configs;
+        std::error_code ec;
+        for (const auto &entry : fs::directory_iterator(workspace.root, ec)) {
+            std::string name = entry.path().filename().string();
+            if (entry.is_regular_file(ec) && std::regex_match(name, rootConfig) && name != "package.json" && name != "package-lock.json")
+                configs.insert(name);
+        }
+        if (!configs.empty())
+            docker.copy(joinWords(configs) + " ./");
+        for (const auto &directory : workspace.included)
+            docker.copy(directory.generic_string() + " " + directory.generic_string());
+        docker.workdir("/app/" + service);
+        docker.cmd({"npm", "start"});
+    }
+    
+    void emitNativeDockerfile(DockerfileIR &docker, const std::string &folderPath, bool hasPackageJson,
+                              const std::set<std::string> &deps, const NativeBuildPlan &plan) {
+        // Offline builds cannot reach apt mirrors; the full node image already ships python3, make and g++.
+        bool offline = hasPackageJson && !vendoredStore(folderPath).empty();
+        docker.from("node:14", "node-builder");
+        if (!plan.buildPackages.empty() && !offline)
+            docker.run(aptInstall(plan.buildPackages));
+        docker.workdir("/app");
+        if (!hasPackageJson)
+            docker.run("npm install " + joinWords(deps));
+        docker.copy(". /app");
+        if (hasPackageJson)
+            emitInstall(docker, folderPath, " --production");
+        
+        if (offline && !plan.runtimePackages.empty()) {
+            docker.from("node:14");
+        } else {
+            docker.from("node:14-slim");
+            if (!plan.runtimePackages.empty())
+                docker.run(aptInstall(plan.runtimePackages));
+        }
+        docker.workdir("/app");
+        docker.copyFrom("node-builder", "/app /app");
+        docker.cmd({"npm", "start"});
+    }
+    
+public:
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        JsonValue manifest;
+        const JsonValue *scripts = readJsonFile(fs::path(folderPath) / "package.json", manifest) ? manifest.get("scripts") : nullptr;
+        const JsonValue *test = scripts ? scripts->get("test") : nullptr;
+        if (!test || test->text.find("no test specified") != std::string::npos)
+            return;
+        if (!hasStage(docker, "node-builder"))
+            addTestStage(docker, "npm test");
+        else if (docker.stages.size() > 1 && operatorOptions.nodeStartup.empty())
+            addTestStage(docker, "npm install && npm test", "node-builder");
+        else
+            addTestStage(docker, "npm test", "node-builder");
+    }
+    
+    // A workspace service is built from the workspace root, which a per-folder compose file cannot mount.
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        JsonValue manifest;
+        if (workspaceBuild || !readJsonFile(fs::path(folderPath) / "package.json", manifest))
+            return false;
+        const JsonValue *scripts = manifest.get("scripts");
+        dev.from("node:14");
+        dev.workdir("/app");
+        auto manifests = existingFiles(folderPath, {"package.json", "package-lock.json", "npm-shrinkwrap.json", ".npmrc"});
+        dev.copy(joinWords(std::set<std::string>(manifests.begin(), manifests.end())) + " /app/");
+        dev.run("npm install");
+        if (scripts && scripts->get("dev")) {
+            dev.cmd({"npm", "run", "dev"});
+        } else {
+            dev.run("npm install -g nodemon");
+            dev.cmd({"nodemon", nodeEntryPoint(folderPath, manifest)});
+        }
+        service.volumes = {"/app/node_modules"};
+        service.ports = {"3000:3000"};
+        return true;
+    }
+};
+
+// JDK packages seen by the import scan and the module providing them. TLS providers are loaded through
+// service lookup, which jdeps cannot see, so jdk.crypto.ec is always added.
+const std::vector<std::pair<std::string, std::string>> javaPackageModules = {
+    {"java.sql", "java.sql"}, {"javax.sql", "java.sql"}, {"java.net.http", "java.net.http"},
+    {"java.util.logging", "java.logging"}, {"java.awt", "java.desktop"}, {"javax.swing", "java.desktop"},
+    {"javax.imageio", "java.desktop"}, {"java.beans", "java.desktop"}, {"javax.sound", "java.desktop"},
+    {"java.rmi", "java.rmi"}, {"javax.naming", "java.naming"}, {"java.lang.management", "java.management"},
+    {"javax.management", "java.management"}, {"javax.xml", "java.xml"}, {"org.w3c.dom", "java.xml"},
+    {"org.xml.sax", "java.xml"}, {"java.util.prefs", "java.prefs"}, {"javax.script", "java.scripting"},
+    {"java.lang.instrument", "java.instrument"}, {"com.sun.net.httpserver", "jdk.httpserver"},
+    {"javax.security.auth.kerberos", "java.security.jgss"}, {"org.ietf.jgss", "java.security.jgss"},
+    {"javax.security.sasl", "java.security.sasl"}, {"javax.tools", "java.compiler"},
+    {"javax.annotation.processing", "java.compiler"}, {"jdk.jfr", "jdk.jfr"}, {"sun.misc", "jdk.unsupported"}};
+
+std::set<std::string> javaModulesFor(const std::set<std::string> &imports) {
+    std::set<std::string> modules = {"jdk.crypto.ec"};
+    for (const auto &import : imports)
+        for (const auto &entry : javaPackageModules)
+            if (import.rfind(entry.first + ".", 0) == 0)
+                modules.insert(entry.second);
+    return modules;
+}
+
+const std::string javaNativeConfig = ".operator/native-image";
+
+class JavaHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "Java"; }
+    std::vector<std::string> sourceExtensions() const override { return {".java"}; }
+    std::vector<std::string> manifestNames() const override { return {"pom.xml", "build.gradle", "build.gradle.kts"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "pom.xml") || fileExistsInFolder(folderPath, "build.gradle"))
+            return true;
+        if (fileWithExtensionExists(folderPath, ".java"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        static const PatternSet imports({"^\\s*import\\s+([a-zA-Z0-9_\\.]+)"});
+        return scanImports(folderPath, {".java"}, imports);
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        bool maven = fileExistsInFolder(folderPath, "pom.xml");
+        bool gradle = fileExistsInFolder(folderPath, "build.gradle") || fileExistsInFolder(folderPath, "build.gradle.kts");
+        if (!maven && !gradle) {
+            docker.from("openjdk:11");
+            docker.workdir("/app");
+            docker.copy(". /app");
+            docker.comment("TODO: Java 빌드 명령어 추가");
+            return;
+        }
+        
+        docker.from(maven ? "maven:3-eclipse-temurin-17" : "gradle:8-jdk17", "java-builder");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        // Tests run in the separate test stage.
+        if (maven && useVendorCache(folderPath, "m2"))
+            docker.offlineRun("mvn -o -Dmaven.repo.local=/app/" + vendorDir + "/m2 install -DskipTests");
+        else
+            docker.run(maven ? "mvn install -DskipTests" : "gradle build -x test");
+        // A thin jar's Class-Path points at the libraries maven-dependency-plugin copied to target/lib.
+        docker.run("cp \"$(ls " + std::string(maven ? "target" : "build/libs") +
+                   "/*.jar | grep -v -e '-sources.jar$' -e '-javadoc.jar$' -e '-plain.jar$' -e '/original-' | head -n 1)\" /app/app.jar"
+                   " && mkdir -p /app/lib && if [ -d target/lib ]; then cp target/lib/*.jar /app/lib/; fi");
+        
+        if (operatorOptions.nativeImage)
+            return emitNativeImage(docker, folderPath);
+        
+        // jdeps analyzes the application classes and every library jar (BOOT-INF/lib of a Spring Boot jar, lib/
+        // next to a thin jar), since JDBC drivers and Spring need modules the application code never names.
+        // Modules used only through reflection or service loaders come from the import scan.
+        std::string modules = "${modules:-java.base}";
+        for (const auto &module : javaModulesFor(deps))
+            modules += "," + module;
+        docker.run("mkdir -p /tmp/app-jar && cd /tmp/app-jar && jar xf /app/app.jar"
+                   " && if [ -d BOOT-INF ]; then set -- BOOT-INF/classes $(ls BOOT-INF/lib/*.jar 2>/dev/null);"
+                   " else set -- /app/app.jar $(ls /app/lib/*.jar 2>/dev/null); fi"
+                   " && modules=$(jdeps --ignore-missing-deps --multi-release 17 --print-module-deps -q \"$@\")"
+                   " && jlink --add-modules \"" + modules + "\" --strip-debug --no-man-pages --no-header-files --compress=2 --output /opt/java"
+                   " && /opt/java/bin/java --list-modules");
+        
+        docker.from("debian:bookworm-slim");
+        docker.env("JAVA_HOME", "/opt/java");
+        docker.env("PATH", "/opt/java/bin:$PATH");
+        docker.copyFrom("java-builder", "/opt/java /opt/java");
+        docker.workdir("/app");
+        docker.copyFrom("java-builder", "/app/app.jar /app/app.jar");
+        docker.copyFrom("java-builder", "/app/lib /app/lib");
+        docker.cmd({"java", "-jar", "app.jar"});
+    }
+    
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        if (!hasStage(docker, "java-builder"))
+            return;
+        if (fileExistsInFolder(folderPath, "pom.xml") && useVendorCache(folderPath, "m2"))
+            addTestStage(docker, "mvn -o -Dmaven.repo.local=/app/" + vendorDir + "/m2 test", "java-builder");
+        else
+            addTestStage(docker, fileExistsInFolder(folderPath, "pom.xml") ? "mvn test" : "gradle test", "java-builder");
+    }
+    
+private:
+    // Reflection/resource configs come from a committed javaNativeConfig, or from running the training
+    // command with the tracing agent ($AGENT_JAVA); `--target native-config --output .operator/native-image`
+    // exports them. Configs under META-INF/native-image in the jar are picked up by native-image itself.
+    void emitNativeImage(DockerfileIR &docker, const std::string &folderPath) {
+        bool committed = fileExistsInFolder(folderPath, javaNativeConfig);
+        bool traced = !committed && !operatorOptions.nativeImageTraining.empty();
+        docker.from("ghcr.io/graalvm/native-image-community:21", "native-builder");
+        docker.workdir("/app");
+        docker.copyFrom("java-builder", "/app/app.jar /app/app.jar");
+        if (committed)
+            docker.copy(javaNativeConfig + " /native-config");
+        if (traced)
+            docker.run("mkdir -p /native-config && AGENT_JAVA=\"java -agentlib:native-image-agent=config-merge-dir=/native-config\" sh -c " +
+                       shellQuote(operatorOptions.nativeImageTraining));
+        docker.run(std::string("mkdir -p /out && native-image --no-fallback") +
+                   (committed || traced ? " -H:ConfigurationFileDirectories=/native-config" : "") + " -jar app.jar -o /out/app");
+        if (traced) {
+            docker.from("scratch", "native-config");
+            docker.copyFrom("native-builder", "/native-config /");
+        }
+        
+        docker.from("gcr.io/distroless/base-debian12");
+        docker.copyFrom("native-builder", "/out/app /app");
+        docker.cmd({"/app"});
+    }
+};
+
+class RubyHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "Ruby"; }
+    std::vector<std::string> sourceExtensions() const override { return {".rb"}; }
+    std::vector<std::string> manifestNames() const override { return {"Gemfile", "Gemfile.lock"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "Gemfile"))
+            return true;
+        if (fileWithExtensionExists(folderPath, ".rb"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        static const PatternSet imports({"require\\s+['\"]([^'\".][^'\"]*)['\"]"});
+        return scanImports(folderPath, {".rb"}, imports);
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        bool hasGemfile = fileExistsInFolder(folderPath, "Gemfile");
+        docker.from("ruby:2.7");
+        docker.workdir("/app");
+        if (!hasGemfile && !deps.empty())
+            docker.run("gem install " + joinWords(deps));
+        docker.copy(". /app");
+        bool offline = hasGemfile && operatorOptions.offline && fileExistsInFolder(folderPath, "vendor/cache");
+        auto inputs = gemfileInputs(folderPath);
+        if (offline && !inputs.empty())
+            inputs.push_back("vendor/cache/");
+        if (offline)
+            docker.offlineRun("bundle install --local", inputs);
+        else if (hasGemfile)
+            docker.run("bundle install", inputs);
+        docker.cmd({"ruby", "main.rb"});
+    }
+    
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        if (!fileExistsInFolder(folderPath, "Gemfile"))
+            return;
+        if (fileExistsInFolder(folderPath, "spec") && fileMentions(folderPath, "Gemfile", std::regex("rspec")))
+            addTestStage(docker, "bundle exec rspec");
+        else if (fileExistsInFolder(folderPath, "test") && fileExistsInFolder(folderPath, "Rakefile"))
+            addTestStage(docker, "bundle exec rake test");
+    }
+    
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        dev.from("ruby:2.7");
+        dev.workdir("/app");
+        auto gemfiles = existingFiles(folderPath, {"Gemfile", "Gemfile.lock"});
+        if (!gemfiles.empty())
+            dev.copy(joinWords(std::set<std::string>(gemfiles.begin(), gemfiles.end())) + " /app/").run("bundle install");
+        if (fileExistsInFolder(folderPath, "config/application.rb")) {
+            dev.cmd({"bundle", "exec", "rails", "server", "-b", "0.0.0.0"});
+            service.ports = {"3000:3000"};
+        } else {
+            dev.run("gem install rerun");
+            dev.cmd({"rerun", "ruby main.rb"});
+        }
+        return true;
+    }
+};
+
+class PHPHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "PHP"; }
+    std::vector<std::string> sourceExtensions() const override { return {".php"}; }
+    std::vector<std::string> manifestNames() const override { return {"composer.json"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "composer.json"))
+            return true;
+        if (fileWithExtensionExists(folderPath, ".php"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        static const PatternSet imports({"(?:require|include)\\s*\\(?\\s*['\"]([^'\"]+)['\"]"});
+        return scanImports(folderPath, {".php"}, imports);
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        docker.from("php:7.4-apache");
+        docker.workdir("/var/www/html");
+        docker.copy(". /var/www/html");
+        if (fileExistsInFolder(folderPath, "composer.json"))
+            docker.run("composer install");
+        else if (!deps.empty())
+            docker.run("composer require " + joinWords(deps));
+        docker.cmd({"apache2-foreground"});
+    }
+    
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "composer.json") && fileMentions(folderPath, "composer.json", std::regex("phpunit/phpunit")))
+            addTestStage(docker, "vendor/bin/phpunit");
+    }
+    
+    // Apache serves the bind-mounted files directly, so edits need no reloader.
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        dev.from("php:7.4-apache");
+        dev.workdir("/var/www/html");
+        if (fileExistsInFolder(folderPath, "composer.json"))
+            dev.copy("composer.json /var/www/html/").run("composer install");
+        dev.cmd({"apache2-foreground"});
+        service.workdir = "/var/www/html";
+        if (fileExistsInFolder(folderPath, "composer.json"))
+            service.volumes = {"/var/www/html/vendor"};
+        service.ports = {"8080:80"};
+        return true;
+    }
+};
+
+class GoHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "Go"; }
+    std::vector<std::string> sourceExtensions() const override { return {".go"}; }
+    std::vector<std::string> manifestNames() const override { return {"go.mod"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "go.mod"))
+            return true;
+        if (fileWithExtensionExists(folderPath, ".go"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        static const PatternSet imports({"^\\s*import\\s+\"([^\"]+)\""});
+        return scanImports(folderPath, {".go"}, imports);
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        if (crossCompiling())
+            return emitCrossDockerfile(docker, folderPath);
+        docker.from("golang:1.16");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        if (operatorOptions.offline && fileExistsInFolder(folderPath, "vendor/modules.txt")) {
+            docker.offlineRun("go build -mod=vendor -o main .");
+        } else {
+            if (fileExistsInFolder(folderPath, "go.mod")) {
+                docker.run("go mod download", goModInputs(folderPath));
+            }
+            docker.run("go build -o main .");
+        }
+        docker.cmd({"./main"});
+    }
+    
+private:
+    void emitCrossDockerfile(DockerfileIR &docker, const std::string &folderPath) {
+        crossBuilder(docker, "golang:1.16", "go-builder");
+        docker.arg("TARGETOS").arg("TARGETARCH");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        std::string build = "CGO_ENABLED=0 GOOS=$TARGETOS GOARCH=$TARGETARCH go build";
+        if (operatorOptions.offline && fileExistsInFolder(folderPath, "vendor/modules.txt")) {
+            docker.offlineRun(build + " -mod=vendor -o /out/main .");
+        } else {
+            if (fileExistsInFolder(folderPath, "go.mod"))
+                docker.run("go mod download", goModInputs(folderPath));
+            docker.run(build + " -o /out/main .");
+        }
+        
+        docker.from("gcr.io/distroless/static-debian11");
+        docker.copyFrom("go-builder", "/out/main /main");
+        docker.cmd({"/main"});
+    }
+    
+public:
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        static const std::regex testFile(".*_test\\.go");
+        bool tests = false;
+        for (const auto &file : projectIndex(folderPath).filesWithExtension(".go"))
+            tests = tests || std::regex_match(file.filename().string(), testFile);
+        if (!tests)
+            return;
+        std::string command = operatorOptions.offline && fileExistsInFolder(folderPath, "vendor/modules.txt") ? "go test -mod=vendor ./..."
+                                                                                                              : "go test ./...";
+        addTestStage(docker, command, hasStage(docker, "go-builder") ? "go-builder" : "");
+    }
+    
+    // air needs a newer Go than the build image, and go.mod compatibility keeps older modules building.
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        dev.from("golang:1.22");
+        dev.workdir("/app");
+        dev.run("go install github.com/air-verse/air@v1.52.3");
+        auto modules = existingFiles(folderPath, {"go.mod", "go.sum"});
+        if (!modules.empty())
+            dev.copy(joinWords(std::set<std::string>(modules.begin(), modules.end())) + " /app/").run("go mod download");
+        dev.cmd({"air", "--build.cmd", "go build -o ./tmp/main .", "--build.bin", "./tmp/main"});
+        service.ports = {"8080:8080"};
+        return true;
+    }
+};
+
+class CSharpHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "C# (.NET)"; }
+    std::vector<std::string> sourceExtensions() const override { return {".cs", ".csproj", ".sln"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileWithExtensionExists(folderPath, ".cs"))
+            return true;
+        for (const auto &entry : fs::directory_iterator(folderPath)) {
+            if (entry.is_regular_file()) {
+                std::string fname = entry.path().filename().string();
+                if (fname.size() >= 7 && fname.substr(fname.size() - 7) == ".csproj")
+                    return true;
+                if (fname.size() >= 4 && fname.substr(fname.size() - 4) == ".sln")
+                    return true;
+            }
+        }
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        return {};
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        if (crossCompiling())
+            return emitCrossDockerfile(docker, folderPath);
+        docker.from("mcr.microsoft.com/dotnet/sdk:5.0");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        docker.run("dotnet restore");
+        docker.run("dotnet build");
+        docker.cmd({"dotnet", "run"});
+    }
+    
+private:
+    // The SDK emits IL for any runtime identifier, so only the framework-dependent publish is per-architecture.
+    void emitCrossDockerfile(DockerfileIR &docker, const std::string &folderPath) {
+        fs::path project = findProjectFile(folderPath);
+        std::string assembly = project.empty() ? "app" : project.stem().string();
+        bool web = !project.empty() && projectIndex(folderPath).contents(project).find("Microsoft.NET.Sdk.Web") != std::string::npos;
+        std::string rid = "case \"$TARGETARCH\" in amd64) rid=linux-x64 ;; arm64) rid=linux-arm64 ;; arm) rid=linux-arm ;; "
+                          "*) echo \"unsupported TARGETARCH $TARGETARCH\" >&2; exit 1 ;; esac";
+        crossBuilder(docker, "mcr.microsoft.com/dotnet/sdk:5.0", "dotnet-builder");
+        docker.arg("TARGETARCH");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        docker.run(rid + " && dotnet restore -r $rid && dotnet publish -c Release -r $rid --self-contained false --no-restore -o /out");
+        
+        docker.from(web ? "mcr.microsoft.com/dotnet/aspnet:5.0" : "mcr.microsoft.com/dotnet/runtime:5.0");
+        docker.workdir("/app");
+        docker.copyFrom("dotnet-builder", "/out /app");
+        docker.cmd({"dotnet", assembly + ".dll"});
+    }
+    
+public:
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        bool tests = false;
+        for (const auto &project : projectIndex(folderPath).filesWithExtension(".csproj"))
+            tests = tests || projectIndex(folderPath).contents(project).find("Microsoft.NET.Test.Sdk") != std::string::npos;
+        if (tests)
+            addTestStage(docker, "dotnet test", hasStage(docker, "dotnet-builder") ? "dotnet-builder" : "");
+    }
+    
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        dev.from("mcr.microsoft.com/dotnet/sdk:5.0");
+        dev.workdir("/app");
+        dev.env("DOTNET_USE_POLLING_FILE_WATCHER", "1");
+        dev.cmd({"dotnet", "watch", "run", "--urls", "http://0.0.0.0:5000"});
+        service.volumes = {"/app/bin", "/app/obj"};
+        service.ports = {"5000:5000"};
+        return true;
+    }
+};
+
+class CppHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "C++"; }
+    std::vector<std::string> sourceExtensions() const override { return {".cpp", ".cc", ".cxx", ".h", ".hpp"}; }
+    std::vector<std::string> manifestNames() const override { return {"CMakeLists.txt", "Makefile"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileWithExtensionExists(folderPath, ".cpp") ||
+            fileWithExtensionExists(folderPath, ".cc") ||
+            fileWithExtensionExists(folderPath, ".cxx"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        return {};
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        if (pgoEnabled(folderPath))
+            return emitPgoDockerfile(docker, folderPath);
+        if (crossCompiling() && !operatorOptions.offline)
+            return emitCrossDockerfile(docker);
+        // gcc:latest ships a newer libstdc++ than Debian, so it is linked statically for the slim runtime.
+        docker.from("gcc:latest", "cpp-builder");
+        bool cached = compileCacheEnabled();
+        if (cached)
+            docker.run(aptInstall({"ccache", "mold"}));
+        else if (!operatorOptions.offline)
+            docker.run(aptInstall({"mold"}));
+        if (cached) {
+            docker.env("CCACHE_DIR", "/root/.ccache");
+            docker.env("CCACHE_BASEDIR", "/app");
+            if (!compileCacheServer("ccache").empty())
+                docker.env("CCACHE_REMOTE_STORAGE", compileCacheServer("ccache"));
+        }
+        docker.workdir("/app");
+        docker.copy(". /app");
+        std::string link = "-static-libstdc++ -static-libgcc $linker -o main";
+        std::string split = splitDebugInfo("main") + " && (mv *.dwo /debug/ 2>/dev/null || true)";
+        if (cached) {
+            // One compiler call per file, so ccache can serve each object separately.
+            compileCacheRun(docker, "ccache", "/root/.ccache",
+                            "ls *.cpp | xargs -P \"$(nproc)\" -I{} ccache g++ -O2 -g -gsplit-dwarf -c {} -o {}.o"
+                            " && g++ " + link + " *.o && " + split);
+        } else {
+            docker.run(fastLinkerProbe + " && g++ -O2 -g -gsplit-dwarf " + link + " *.cpp && " + split);
+        }
+        emitDebugStage(docker, "cpp-builder");
+        
+        docker.from("debian:bookworm-slim");
+        docker.workdir("/app");
+        docker.copyFrom("cpp-builder", "/app/main /app/main");
+        docker.cmd({"./main"});
+    }
+    
+    // entr restarts the rebuild-and-run on every change; -d exits when a file is added, so the loop rescans.
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        dev.from("gcc:latest");
+        dev.run(aptInstall({"entr"}));
+        dev.workdir("/app");
+        dev.cmd({"sh", "-c", "while true; do ls *.cpp *.h *.hpp 2>/dev/null | entr -rnd sh -c 'g++ -O0 -g -o /tmp/main *.cpp && /tmp/main'; done"});
+        return true;
+    }
+    
+private:
+    // Target sysroot packages come from apt, so --offline keeps the native single-platform build.
+    void emitCrossDockerfile(DockerfileIR &docker) {
+        crossBuilder(docker, crossToolsImage, "xx");
+        crossBuilder(docker, "debian:bookworm", "cpp-builder");
+        docker.copyFrom("xx", "/ /");
+        docker.run(aptInstall({"clang", "lld"}));
+        docker.arg("TARGETPLATFORM");
+        docker.run("xx-apt-get install -y libc6-dev libstdc++-12-dev");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        docker.run("mkdir -p /out && xx-clang++ -O2 -o /out/main *.cpp && xx-verify /out/main");
+        
+        docker.from("debian:bookworm-slim");
+        docker.copyFrom("cpp-builder", "/out/main /usr/local/bin/main");
+        docker.cmd({"main"});
+    }
+    
+    void emitPgoDockerfile(DockerfileIR &docker, const std::string &folderPath) {
+        bool committed = fileExistsInFolder(folderPath, pgoProfile);
+        std::string profile = committed ? "/app/" + pgoProfile : "/pgo/merged.profdata";
+        docker.from("debian:bookworm", "cpp-builder");
+        docker.run(aptInstall({"clang", "lld", "llvm"}));
+        docker.workdir("/app");
+        docker.copy(". /app");
+        if (!committed) {
+            docker.run("clang++ -O2 -fprofile-instr-generate -o /app/main *.cpp");
+            docker.run("mkdir -p /pgo && PGO_BINARY=/app/main LLVM_PROFILE_FILE=/pgo/%p-%m.profraw sh -c " +
+                       shellQuote(operatorOptions.pgoTraining));
+            docker.run("llvm-profdata merge -o " + profile + " /pgo/*.profraw");
+        }
+        docker.run("mkdir -p /out && clang++ -O2 -flto=thin -fuse-ld=lld -fprofile-instr-use=" + profile +
+                   " -Wno-profile-instr-out-of-date -Wno-profile-instr-unprofiled -o /out/main *.cpp");
+        if (!committed) {
+            docker.from("scratch", "pgo-profile");
+            docker.copyFrom("cpp-builder", profile + " /merged.profdata");
+        }
+        
+        docker.from("debian:bookworm-slim");
+        docker.copyFrom("cpp-builder", "/out/main /usr/local/bin/main");
+        docker.cmd({"main"});
+    }
+};
+
+class RustHandler : public LanguageHandler {
+public:
+    std::string getName() const override { return "Rust"; }
+    std::vector<std::string> sourceExtensions() const override { return {".rs"}; }
+    std::vector<std::string> manifestNames() const override { return {"Cargo.toml"}; }
+    
+    bool detect(const std::string &folderPath) override {
+        if (fileExistsInFolder(folderPath, "Cargo.toml"))
+            return true;
+        if (fileWithExtensionExists(folderPath, ".rs"))
+            return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        return {};
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        if (fileExistsInFolder(folderPath, "Cargo.toml") && pgoEnabled(folderPath))
+            return emitPgoDockerfile(docker, folderPath);
+        if (crossCompiling() && !operatorOptions.offline && fileExistsInFolder(folderPath, "Cargo.toml"))
+            return emitCrossDockerfile(docker, folderPath);
+        releaseBuild = false;
+        if (!fileExistsInFolder(folderPath, "Cargo.toml")) {
+            docker.from("rust:latest");
+            docker.workdir("/app");
+            docker.copy(". /app");
+            docker.comment("Cargo.toml 파일을 추가하여 의존성 관리를 해주세요");
+            docker.cmd({"./target/release/<your_binary>"});
+            return;
+        }
+        
+        std::string binary = cargoPackageName(folderPath);
+        std::string build = releaseEnv + " cargo build --release";
+        std::string split = splitDebugInfo("target/release/" + binary) + " && (cp target/release/*.dwp /debug/ 2>/dev/null || true)";
+        docker.from("rust:latest", "rust-builder");
+        bool cached = compileCacheEnabled();
+        if (!operatorOptions.offline)
+            docker.run(aptInstall({"mold"}));
+        if (cached) {
+            docker.run("curl -fsSL https://github.com/mozilla/sccache/releases/download/" + sccacheVersion + "/sccache-" + sccacheVersion +
+                       "-$(uname -m)-unknown-linux-musl.tar.gz | tar -xz --strip-components=1 -C /usr/local/bin --wildcards '*/sccache'");
+            docker.env("RUSTC_WRAPPER", "sccache");
+            docker.env("CARGO_INCREMENTAL", "0");
+            docker.env("SCCACHE_DIR", "/root/.cache/sccache");
+            if (!compileCacheServer("sccache").empty())
+                docker.env("SCCACHE_WEBDAV_ENDPOINT", compileCacheServer("sccache"));
+        }
+        docker.workdir("/app");
+        docker.copy(". /app");
+        if (cached)
+            compileCacheRun(docker, "sccache", "/root/.cache/sccache", build + " && " + split);
+        else if (useVendorCache(folderPath, "cargo"))
+            docker.offlineRun(fastLinkerProbe + " && " + build + " --offline --config " + vendorDir + "/cargo-config.toml && " + split);
+        else
+            docker.run(fastLinkerProbe + " && " + build + " && " + split);
+        emitDebugStage(docker, "rust-builder");
+        releaseBuild = true;
+        
+        docker.from("debian:bookworm-slim");
+        docker.workdir("/app");
+        docker.copyFrom("rust-builder", "/app/target/release/" + binary + " /app/" + binary);
+        docker.cmd({"./" + binary});
+    }
+    
+    bool emitDevStage(DockerfileIR &dev, DevService &service, const std::string &folderPath) override {
+        if (!fileExistsInFolder(folderPath, "Cargo.toml"))
+            return false;
+        dev.from("rust:latest");
+        dev.workdir("/app");
+        dev.run("cargo install cargo-watch --locked");
+        // cargo fetch needs a target to read the manifest; the bind mount replaces the placeholder.
+        auto manifests = existingFiles(folderPath, {"Cargo.toml", "Cargo.lock"});
+        if (!fileMentions(folderPath, "Cargo.toml", std::regex("(^|\\n)\\[workspace\\]")))
+            dev.copy(joinWords(std::set<std::string>(manifests.begin(), manifests.end())) + " /app/")
+                .run("mkdir -p src && touch src/main.rs && cargo fetch && rm -rf src");
+        dev.cmd({"cargo", "watch", "-x", "run"});
+        // The registry volume keeps crates added while the container runs.
+        service.volumes = {"/app/target", "/usr/local/cargo/registry"};
+        service.ports = {"8080:8080"};
+        return true;
+    }
+    
+    // Tests run with the build's RUSTFLAGS and release profile, so cargo reuses the compiled dependencies.
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        if (!hasStage(docker, "rust-builder"))
+            return;
+        std::string test = releaseBuild ? fastLinkerProbe + " && " + releaseEnv + " cargo test --release" : "cargo test --release";
+        if (useVendorCache(folderPath, "cargo"))
+            addTestStage(docker, test + " --offline --config " + vendorDir + "/cargo-config.toml", "rust-builder");
+        else
+            addTestStage(docker, test, "rust-builder");
+    }
+    
+private:
+    const std::string releaseEnv = "RUSTFLAGS=\"$RUSTFLAGS ${linker:+-C link-arg=$linker}\" CARGO_PROFILE_RELEASE_DEBUG=true "
+                                   "CARGO_PROFILE_RELEASE_SPLIT_DEBUGINFO=packed";
+    bool releaseBuild = false;
+    
+    void emitCrossDockerfile(DockerfileIR &docker, const std::string &folderPath) {
+        std::string binary = cargoPackageName(folderPath);
+        crossBuilder(docker, crossToolsImage, "xx");
+        crossBuilder(docker, "rust:1-bookworm", "rust-builder");
+        docker.copyFrom("xx", "/ /");
+        docker.run(aptInstall({"clang", "lld"}));
+        docker.arg("TARGETPLATFORM");
+        docker.run("xx-apt-get install -y gcc libc6-dev");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        docker.run("xx-cargo build --release --target-dir /app/target && mkdir -p /out"
+                   " && cp target/$(xx-cargo --print-target-triple)/release/" + binary + " /out/" + binary +
+                   " && xx-verify /out/" + binary);
+        
+        docker.from("debian:bookworm-slim");
+        docker.copyFrom("rust-builder", "/out/" + binary + " /usr/local/bin/" + binary);
+        docker.cmd({binary});
+    }
+    
+    void emitPgoDockerfile(DockerfileIR &docker, const std::string &folderPath) {
+        std::string binary = cargoPackageName(folderPath);
+        bool committed = fileExistsInFolder(folderPath, pgoProfile);
+        std::string profile = committed ? "/app/" + pgoProfile : "/pgo/merged.profdata";
+        docker.from("rust:1-bookworm", "rust-builder");
+        if (!committed)
+            docker.run("rustup component add llvm-tools-preview");
+        docker.workdir("/app");
+        docker.copy(". /app");
+        if (!committed) {
+            // llvm-profdata from llvm-tools matches the LLVM version rustc writes profiles with.
+            docker.run("RUSTFLAGS='-Cprofile-generate=/pgo' cargo build --release --target-dir /tmp/pgo-target");
+            docker.run("PGO_BINARY=/tmp/pgo-target/release/" + binary + " sh -c " + shellQuote(operatorOptions.pgoTraining));
+            docker.run("$(find \"$(rustc --print sysroot)\" -name llvm-profdata -type f | head -n 1) merge -o " + profile + " /pgo");
+        }
+        docker.run("RUSTFLAGS='-Cprofile-use=" + profile + " -Cllvm-args=-pgo-warn-mismatch' CARGO_PROFILE_RELEASE_LTO=fat"
+                   " CARGO_PROFILE_RELEASE_CODEGEN_UNITS=1 cargo build --release && mkdir -p /out && cp target/release/" +
+                   binary + " /out/" + binary);
+        if (!committed) {
+            docker.from("scratch", "pgo-profile");
+            docker.copyFrom("rust-builder", profile + " /merged.profdata");
+        }
+        
+        docker.from("debian:bookworm-slim");
+        docker.copyFrom("rust-builder", "/out/" + binary + " /usr/local/bin/" + binary);
+        docker.cmd({binary});
+    }
+};
+
+struct LanguageDefinition {
+    std::string source;
+    std::string name;
+    std::vector<std::string> extensions;
+    std::vector<std::string> manifests;
+    std::vector<std::string> importPatterns;
+    std::string baseImage;
+    std::string workdir = "/app";
+    std::string install;
+    std::string installEach;
+    std::string build;
+    std::string run;
+    std::string test;
+};
+
+// Parses one `key = value` definition file. Every problem is reported as "file:line: message" so a
+// bad definition is skipped with a clear reason instead of silently producing a broken Dockerfile.
+bool parseLanguageDefinition(const fs::path &path, LanguageDefinition &def, std::vector<std::string> &errors) {
+    std::ifstream in(path);
+    if (!in) {
+        errors.push_back(path.string() + ": 파일을 열 수 없습니다");
+        return false;
+    }
+    def = LanguageDefinition();
+    def.source = path.string();
+    size_t errorCount = errors.size();
+    auto fail = [&](int lineNo, const std::string &message) {
+        errors.push_back(path.string() + ":" + std::to_string(lineNo) + ": " + message);
+    };
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        line = trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            fail(lineNo, "'key = value' 형식이 아닙니다");
+            continue;
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        if (key == "name") {
+            def.name = value;
+        } else if (key == "extensions") {
+            for (auto &ext : splitWords(value))
+                def.extensions.push_back(ext[0] == '.' ? ext : "." + ext);
+        } else if (key == "manifests") {
+            for (auto &manifest : splitWords(value))
+                def.manifests.push_back(manifest);
+        } else if (key == "import") {
+            try {
+                std::regex compiled(value);
+                if (compiled.mark_count() != 1)
+                    fail(lineNo, "import 패턴에는 캡처 그룹이 정확히 하나 있어야 합니다 (비캡처 그룹은 (?:...))");
+                else
+                    def.importPatterns.push_back(value);
+            } catch (const std::regex_error &e) {
+                fail(lineNo, std::string("잘못된 정규식입니다: ") + e.what());
+            }
+        } else if (key == "base_image") {
+            def.baseImage = value;
+        } else if (key == "workdir") {
+            def.workdir = value;
+        } else if (key == "install") {
+            def.install = value;
+        } else if (key == "install_each") {
+            def.installEach = value;
+        } else if (key == "build") {
+            def.build = value;
+        } else if (key == "run") {
+            def.run = value;
+        } else if (key == "test") {
+            def.test = value;
+        } else {
+            fail(lineNo, "알 수 없는 키입니다: " + key);
+        }
+    }
+    if (def.name.empty())
+        fail(lineNo, "name 이 필요합니다");
+    if (def.extensions.empty() && def.manifests.empty())
+        fail(lineNo, "extensions 또는 manifests 중 하나는 필요합니다");
+    if (def.baseImage.empty())
+        fail(lineNo, "base_image 가 필요합니다");
+    if (def.run.empty())
+        fail(lineNo, "run 이 필요합니다");
+    return errors.size() == errorCount;
+}
+
+std::vector<fs::path> languageDefinitionDirs() {
+    std::vector<fs::path> dirs;
+    if (const char *paths = std::getenv("OPERATOR_LANG_PATH")) {
+        std::istringstream in(paths);
+        std::string dir;
+        while (std::getline(in, dir, ':'))
+            if (!dir.empty())
+                dirs.push_back(dir);
+    }
+    if (const char *xdg = std::getenv("XDG_CONFIG_HOME"))
+        dirs.push_back(fs::path(xdg) / "operator" / "languages");
+    else if (const char *home = std::getenv("HOME"))
+        dirs.push_back(fs::path(home) / ".config" / "operator" / "languages");
+    dirs.push_back("languages");
+    return dirs;
+}
+
+// Binary snapshot of the parsed definitions, valid while the set of .lang files and their
+// size/mtime are unchanged; startup then skips parsing and validation entirely.
+class LanguageDefinitionCache {
+public:
+    static bool load(const std::string &signature, std::vector<LanguageDefinition> &defs,
+                     std::vector<std::string> &errors) {
+        std::ifstream in(path(), std::ios::binary);
+        std::string magic(8, '\0');
+        if (!in.read(&magic[0], 8) || magic != std::string("OPLANG2\0", 8) || readString(in) != signature)
+            return false;
+        uint32_t count = readU32(in);
+        for (uint32_t i = 0; in && i < count; ++i) {
+            LanguageDefinition def;
+            def.source = readString(in);
+            def.name = readString(in);
+            def.extensions = readList(in);
+            def.manifests = readList(in);
+            def.importPatterns = readList(in);
+            def.baseImage = readString(in);
+            def.workdir = readString(in);
+            def.install = readString(in);
+            def.installEach = readString(in);
+            def.build = readString(in);
+            def.run = readString(in);
+            def.test = readString(in);
+            defs.push_back(std::move(def));
+        }
+        errors = readList(in);
+        return static_cast<bool>(in);
+    }
+    
+    static void save(const std::string &signature, const std::vector<LanguageDefinition> &defs,
+                     const std::vector<std::string> &errors) {
+        std::error_code ec;
+        fs::create_directories(path().parent_path(), ec);
+        fs::path temp = path();
+        temp += ".tmp";
+        std::ofstream out(temp, std::ios::binary);
+        if (!out)
+            return;
+        out.write("OPLANG2\0", 8);
+        writeString(out, signature);
+        writeU32(out, static_cast<uint32_t>(defs.size()));
+        for (const auto &def : defs) {
+            writeString(out, def.source);
+            writeString(out, def.name);
+            writeList(out, def.extensions);
+            writeList(out, def.manifests);
+            writeList(out, def.importPatterns);
+            writeString(out, def.baseImage);
+            writeString(out, def.workdir);
+            writeString(out, def.install);
+            writeString(out, def.installEach);
+            writeString(out, def.build);
+            writeString(out, def.run);
+            writeString(out, def.test);
+        }
+        writeList(out, errors);
+        out.close();
+        fs::rename(temp, path(), ec);
+    }
+    
+private:
+    static fs::path path() { return operatorCacheDir() / "languages.bin"; }
+    
+    static void writeU32(std::ostream &out, uint32_t value) {
+        unsigned char bytes[4] = {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+                                  static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+        out.write(reinterpret_cast<const char *>(bytes), 4);
+    }
+    
+    static uint32_t readU32(std::istream &in) {
+        unsigned char bytes[4] = {};
+        in.read(reinterpret_cast<char *>(bytes), 4);
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+    
+    static void writeString(std::ostream &out, const std::string &text) {
+        writeU32(out, static_cast<uint32_t>(text.size()));
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    
+    static std::string readString(std::istream &in) {
+        uint32_t size = readU32(in);
+        if (!in || size > (1u << 24)) {
+            in.setstate(std::ios::failbit);
+            return "";
+        }
+        std::string text(size, '\0');
+        in.read(&text[0], size);
+        return text;
+    }
+    
+    static void writeList(std::ostream &out, const std::vector<std::string> &items) {
+        writeU32(out, static_cast<uint32_t>(items.size()));
+        for (const auto &item : items)
+            writeString(out, item);
+    }
+    
+    static std::vector<std::string> readList(std::istream &in) {
+        std::vector<std::string> items(std::min<uint32_t>(readU32(in), 1u << 16));
+        for (auto &item : items)
+            item = readString(in);
+        return items;
+    }
+};
+
+struct LoadedLanguages {
+    std::vector<LanguageDefinition> definitions;
+    std::vector<std::string> errors;
+};
+
+const LoadedLanguages &loadLanguageDefinitions() {
+    static const LoadedLanguages loaded = [] {
+        LoadedLanguages result;
+        std::vector<fs::path> files;
+        for (const auto &dir : languageDefinitionDirs()) {
+            std::error_code ec;
+            for (const auto &entry : fs::directory_iterator(dir, ec)) {
+                if (entry.path().extension() == ".lang" && entry.is_regular_file(ec))
+                    files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        
+        std::string signature;
+        for (const auto &file : files) {
+            std::error_code ec;
+            signature += fs::absolute(file).string() + "|" + std::to_string(fs::file_size(file, ec)) + "|" +
+                         std::to_string(fileTimeNanos(fs::last_write_time(file, ec))) + "\n";
+        }
+        if (LanguageDefinitionCache::load(signature, result.definitions, result.errors))
+            return result;
+        
+        result = LoadedLanguages();
+        std::set<std::string> names;
+        for (const auto &file : files) {
+            LanguageDefinition def;
+            if (!parseLanguageDefinition(file, def, result.errors))
+                continue;
+            if (!names.insert(def.name).second) {
+                result.errors.push_back(file.string() + ": 이미 정의된 언어입니다: " + def.name);
+                continue;
+            }
+            result.definitions.push_back(std::move(def));
+        }
+        LanguageDefinitionCache::save(signature, result.definitions, result.errors);
+        return result;
+    }();
+    return loaded;
+}
+
+std::string expandTemplate(std::string text, const LanguageDefinition &def, const std::set<std::string> &deps) {
+    std::string joined;
+    for (const auto &dep : deps)
+        joined += (joined.empty() ? "" : " ") + dep;
+    const std::pair<std::string, std::string> vars[] = {{"{deps}", joined}, {"{workdir}", def.workdir}};
+    for (const auto &var : vars) {
+        for (size_t pos = text.find(var.first); pos != std::string::npos; pos = text.find(var.first, pos + var.second.size()))
+            text.replace(pos, var.first.size(), var.second);
+    }
+    return text;
+}
+
+// A `run` value as exec-form JSON, split into words the way sh does (quotes, backslashes). Values that
+// need a shell (variables, pipes, redirections, globs) or have an unbalanced quote stay in shell form.
+std::string execForm(const std::string &command) {
+    std::vector<std::string> words;
+    std::string word;
+    bool inWord = false;
+    char quote = 0;
+    for (size_t i = 0; i < command.size(); ++i) {
+        char c = command[i];
+        if (quote == '\'') {
+            if (c == '\'')
+                quote = 0;
+            else
+                word += c;
+        } else if (quote == '"') {
+            if (c == '"')
+                quote = 0;
+            else if (c == '$' || c == '`')
+                return command;
+            else if (c == '\\' && i + 1 < command.size() && std::strchr("\"\\", command[i + 1]))
+                word += command[++i];
+            else
+                word += c;
+        } else if (c && std::strchr("$`|&;<>()*?", c)) {
+            return command;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            inWord = true;
+        } else if (c == '\\' && i + 1 < command.size()) {
+            word += command[++i];
+            inWord = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inWord)
+                words.push_back(word);
+            word.clear();
+            inWord = false;
+        } else {
+            word += c;
+            inWord = true;
+        }
+    }
+    if (quote)
+        return command;
+    if (inWord)
+        words.push_back(word);
+    return jsonArray(words);
+}
+
+class DeclarativeHandler : public LanguageHandler {
+public:
+    explicit DeclarativeHandler(const LanguageDefinition &def) : def(def), imports(def.importPatterns) {}
+    
+    std::string getName() const override { return def.name; }
+    std::vector<std::string> manifestNames() const override { return def.manifests; }
+    std::vector<std::string> sourceExtensions() const override { return def.extensions; }
+    
+    bool detect(const std::string &folderPath) override {
+        for (const auto &manifest : def.manifests)
+            if (fileExistsInFolder(folderPath, manifest))
+                return true;
+        for (const auto &extension : def.extensions)
+            if (fileWithExtensionExists(folderPath, extension))
+                return true;
+        return false;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        if (def.importPatterns.empty())
+            return {};
+        return scanImports(folderPath, def.extensions, imports);
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        bool hasManifest = false;
+        for (const auto &manifest : def.manifests)
+            hasManifest = hasManifest || fileExistsInFolder(folderPath, manifest);
+        
+        docker.from(def.baseImage);
+        docker.workdir(def.workdir);
+        docker.copy(". " + def.workdir);
+        if (hasManifest && !def.install.empty())
+            docker.run(expandTemplate(def.install, def, deps));
+        else if (!deps.empty() && !def.installEach.empty())
+            docker.run(expandTemplate(def.installEach, def, deps));
+        if (!def.build.empty())
+            docker.run(expandTemplate(def.build, def, deps));
+        docker.instruction(DockerOp::Cmd, "CMD", execForm(expandTemplate(def.run, def, deps)));
+    }
+    
+    void emitTestStage(DockerfileIR &docker, const std::string &folderPath) override {
+        if (!def.test.empty())
+            addTestStage(docker, expandTemplate(def.test, def, {}));
+    }
+    
+private:
+    LanguageDefinition def;
+    PatternSet imports;
+};
+
+struct operator_project {
+    const ProjectIndex *index;
+    std::string root;
+};
+
+namespace plugin_host {
+
+const char *root(const operator_project *p) { return p->root.c_str(); }
+
+int fileExists(const operator_project *p, const char *relativePath) {
+    return relativePath && fs::exists(p->index->rootPath() / relativePath) ? 1 : 0;
+}
+
+size_t fileCount(const operator_project *p, const char *extension) {
+    return extension ? p->index->relativeFilesWithExtension(extension).size() : 0;
+}
+
+const char *filePath(const operator_project *p, const char *extension, size_t i) {
+    if (!extension)
+        return nullptr;
+    const auto &files = p->index->relativeFilesWithExtension(extension);
+    return i < files.size() ? files[i].c_str() : nullptr;
+}
+
+const char *fileContents(const operator_project *p, const char *relativePath, size_t *size) {
+    if (!relativePath)
+        return nullptr;
+    fs::path path = p->index->rootPath() / relativePath;
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec))
+        return nullptr;
+    const std::string &data = p->index->contents(path);
+    if (size)
+        *size = data.size();
+    return data.c_str();
+}
+
+const operator_host_api api = {OPERATOR_PLUGIN_ABI_VERSION, sizeof(operator_host_api), root, fileExists,
+                               fileCount, filePath, fileContents};
+
+struct StringSink : operator_sink {
+    std::vector<std::string> items;
+    StringSink() {
+        emit = [](operator_sink *sink, const char *text) {
+            if (text)
+                static_cast<StringSink *>(sink)->items.push_back(text);
+        };
+    }
+};
+
+}
+
+class PluginHandler : public LanguageHandler {
+public:
+    explicit PluginHandler(const operator_plugin *plugin) : plugin(plugin) {}
+    
+    std::string getName() const override { return plugin->name ? plugin->name : "(plugin)"; }
+    
+    bool detect(const std::string &folderPath) override {
+        auto view = project(folderPath);
+        return plugin->detect && plugin->detect(&plugin_host::api, &view) != 0;
+    }
+    
+    std::set<std::string> extractDependencies(const std::string &folderPath) override {
+        if (!plugin->extract)
+            return {};
+        auto view = project(folderPath);
+        plugin_host::StringSink sink;
+        plugin->extract(&plugin_host::api, &view, &sink);
+        return std::set<std::string>(sink.items.begin(), sink.items.end());
+    }
+    
+    void emitDockerfile(DockerfileIR &docker, const std::string &folderPath, const std::set<std::string> &deps) override {
+        if (!plugin->render)
+            return;
+        auto view = project(folderPath);
+        std::vector<const char *> depList;
+        for (const auto &dep : deps)
+            depList.push_back(dep.c_str());
+        plugin_host::StringSink sink;
+        plugin->render(&plugin_host::api, &view, depList.data(), depList.size(), &sink);
+        std::string text;
+        for (const auto &chunk : sink.items)
+            text += chunk;
+        auto parsed = parseDockerfile(text);
+        for (const auto &line : parsed.preamble)
+            if (std::find(docker.preamble.begin(), docker.preamble.end(), line) == docker.preamble.end())
+                docker.preamble.push_back(line);
+        docker.stages.insert(docker.stages.end(), parsed.stages.begin(), parsed.stages.end());
+    }
+    
+private:
+    static operator_project project(const std::string &folderPath) {
+        operator_project view;
+        view.index = &projectIndex(folderPath);
+        view.root = fs::absolute(folderPath).string();
+        return view;
+    }
+    
+    const operator_plugin *plugin;
+};
+
+struct LoadedPlugins {
+    std::vector<std::pair<std::string, const operator_plugin *>> plugins;
+    std::vector<std::string> errors;
+};
+
+std::vector<fs::path> pluginDirs() {
+    std::vector<fs::path> dirs;
+    if (const char *paths = std::getenv("OPERATOR_PLUGIN_PATH")) {
+        std::istringstream in(paths);
+        std::string dir;
+        while (std::getline(in, dir, ':'))
+            if (!dir.empty())
+                dirs.push_back(dir);
+    }
+    if (const char *xdg = std::getenv("XDG_CONFIG_HOME"))
+        dirs.push_back(fs::path(xdg) / "operator" / "plugins");
+    else if (const char *home = std::getenv("HOME"))
+        dirs.push_back(fs::path(home) / ".config" / "operator" / "plugins");
+    dirs.push_back("plugins");
+    return dirs;
+}
+
+// Shared objects stay loaded for the life of the process; their plugin structs are referenced directly.
+const LoadedPlugins &loadPlugins() {
+    static const LoadedPlugins loaded = [] {
+        LoadedPlugins result;
+        std::vector<fs::path> files;
+        for (const auto &dir : pluginDirs()) {
+            std::error_code ec;
+            for (const auto &entry : fs::directory_iterator(dir, ec))
+                if (entry.path().extension() == ".so" && entry.is_regular_file(ec))
+                    files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+        for (const auto &file : files) {
+            void *handle = dlopen(fs::absolute(file).c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (!handle) {
+                result.errors.push_back(file.string() + ": " + dlerror());
+                continue;
+            }
+            auto entry = reinterpret_cast<operator_plugin_entry_fn>(dlsym(handle, "operator_plugin_entry"));
+            const operator_plugin *plugin = entry ? entry(OPERATOR_PLUGIN_ABI_VERSION) : nullptr;
+            if (!entry) {
+                result.errors.push_back(file.string() + ": operator_plugin_entry 심볼이 없습니다");
+            } else if (!plugin || plugin->abi_version != OPERATOR_PLUGIN_ABI_VERSION) {
+                result.errors.push_back(file.string() + ": 지원하지 않는 플러그인 ABI 버전입니다 (host " +
+                                        std::to_string(OPERATOR_PLUGIN_ABI_VERSION) + ", plugin " +
+                                        (plugin ? std::to_string(plugin->abi_version) : std::string("?")) + ")");
+            } else if (plugin->struct_size < sizeof(operator_plugin) || !plugin->name || !plugin->detect) {
+                result.errors.push_back(file.string() + ": 플러그인 정의가 올바르지 않습니다");
+            } else {
+                result.plugins.emplace_back(file.string(), plugin);
+                continue;
+            }
+            dlclose(handle);
+        }
+        return result;
+    }();
+    return loaded;
+}
+
+bool globMatch(const char *pattern, const char *path) {
+    while (*pattern) {
+        if (pattern[0] == '*' && pattern[1] == '*') {
+            while (*pattern == '*')
+                ++pattern;
+            if (*pattern == '/') {
+                ++pattern;
+                for (const char *s = path;; ++s) {
+                    if ((s == path || s[-1] == '/') && globMatch(pattern, s))
+                        return true;
+                    if (!*s)
+                        return false;
+                }
+            }
+            for (const char *s = path;; ++s) {
+                if (globMatch(pattern, s))
+                    return true;
+                if (!*s)
+                    return false;
+            }
+        }
+        if (*pattern == '*') {
+            ++pattern;
+            for (const char *s = path;; ++s) {
+                if (globMatch(pattern, s))
+                    return true;
+                if (!*s || *s == '/')
+                    return false;
+            }
+        }
+        if (!*path)
+            return false;
+        if (*pattern == '?') {
+            if (*path == '/')
+                return false;
+        } else if (*pattern == '[') {
+            const char *p = pattern + 1;
+            bool negate = (*p == '!' || *p == '^');
+            if (negate)
+                ++p;
+            bool matched = false;
+            for (bool first = true; *p && (first || *p != ']'); first = false) {
+                char lo = *p == '\\' && p[1] ? *++p : *p;
+                char hi = lo;
+                if (p[1] == '-' && p[2] && p[2] != ']') {
+                    p += 2;
+                    hi = *p == '\\' && p[1] ? *++p : *p;
+                }
+                if (lo <= *path && *path <= hi)
+                    matched = true;
+                ++p;
+            }
+            if (*p != ']' || matched == negate || *path == '/')
+                return false;
+            pattern = p;
+        } else {
+            if (*pattern == '\\' && pattern[1])
+                ++pattern;
+            if (*pattern != *path)
+                return false;
+        }
+        ++pattern;
+        ++path;
+    }
+    return !*path;
+}
+
+// Matches the path itself or any of its parent directories, as Docker does for .dockerignore and COPY sources.
+bool globMatchesOrParent(const std::string &pattern, const std::string &path) {
+    if (globMatch(pattern.c_str(), path.c_str()))
+        return true;
+    for (size_t pos = path.find('/'); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        if (globMatch(pattern.c_str(), path.substr(0, pos).c_str()))
+            return true;
+    }
+    return false;
+}
+
+std::string cleanContextPattern(std::string pattern) {
+    while (!pattern.empty() && std::isspace(static_cast<unsigned char>(pattern.back())))
+        pattern.pop_back();
+    size_t start = pattern.find_first_not_of(" \t");
+    pattern = start == std::string::npos ? "" : pattern.substr(start);
+    std::string cleaned = fs::path(pattern).lexically_normal().generic_string();
+    while (!cleaned.empty() && cleaned.front() == '/')
+        cleaned.erase(0, 1);
+    while (cleaned.size() > 1 && cleaned.back() == '/')
+        cleaned.pop_back();
+    return cleaned.empty() ? "." : cleaned;
+}
+
+class DockerIgnore {
+public:
+    explicit DockerIgnore(const std::string &folderPath) {
+        std::ifstream file(fs::path(folderPath) / ".dockerignore");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            bool negate = line[0] == '!';
+            std::string pattern = cleanContextPattern(negate ? line.substr(1) : line);
+            if (pattern == ".")
+                continue;
+            rules.push_back({pattern, negate});
+            hasExceptions = hasExceptions || negate;
+        }
+    }
+    
+    bool excluded(const std::string &relativePath) const {
+        if (relativePath == "Dockerfile" || relativePath == ".dockerignore")
+            return false;
+        bool result = false;
+        for (const auto &rule : rules) {
+            if (rule.negate != result)
+                continue;
+            if (globMatchesOrParent(rule.pattern, relativePath))
+                result = !rule.negate;
+        }
+        return result;
+    }
+    
+    // Without exception rules an excluded directory can never contribute files, so the walk may prune it.
+    bool canPrune() const { return !hasExceptions; }
+    
+private:
+    struct Rule {
+        std::string pattern;
+        bool negate;
+    };
+    std::vector<Rule> rules;
+    bool hasExceptions = false;
+};
+
+std::vector<std::string> dockerfileCopySources(const std::string &dockerfile) {
+    std::vector<std::string> sources;
+    std::istringstream in(dockerfile);
+    std::string line, instruction;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (instruction.empty() && (line.empty() || line[0] == '#'))
+            continue;
+        if (!line.empty() && line.back() == '\\') {
+            instruction += line.substr(0, line.size() - 1) + " ";
+            continue;
+        }
+        instruction += line;
+        std::smatch match;
+        static const std::regex copyRegex("^\\s*(COPY|ADD)\\s+(.*)$", std::regex::icase);
+        if (std::regex_match(instruction, match, copyRegex)) {
+            std::string args = match[2];
+            std::vector<std::string> words;
+            static const std::regex jsonWord("\"([^\"]*)\"");
+            if (args.find('[') != std::string::npos && args.find('[') < args.find('"')) {
+                for (std::sregex_iterator it(args.begin(), args.end(), jsonWord), end; it != end; ++it)
+                    words.push_back((*it)[1]);
+            } else {
+                std::istringstream argStream(args);
+                std::string word;
+                while (argStream >> word)
+                    words.push_back(word);
+            }
+            bool fromStage = false;
+            while (!words.empty() && words.front().rfind("--", 0) == 0) {
+                fromStage = fromStage || words.front().rfind("--from=", 0) == 0;
+                words.erase(words.begin());
+            }
+            if (!fromStage && words.size() >= 2) {
+                for (size_t i = 0; i + 1 < words.size(); ++i) {
+                    if (words[i].rfind("<<", 0) != 0 && words[i].find("://") == std::string::npos)
+                        sources.push_back(cleanContextPattern(words[i]));
+                }
+            }
+        }
+        instruction.clear();
+    }
+    return sources;
+}
+
+struct ContextEntry {
+    std::string path;
+    fs::file_type type;
+    bool executable;
+};
+
+// A workspace service's Dockerfile is built from the workspace root: returns that root and the Dockerfile's
+// path inside it. Every other project is its own context.
+std::string buildContextDir(const std::string &folderPath, const std::string &dockerfile, std::string &dockerfileName) {
+    dockerfileName = "Dockerfile";
+    if (dockerfile.find("# " + workspaceContextMarker) == std::string::npos)
+        return folderPath;
+    fs::path folder = absoluteFolder(folderPath);
+    fs::path root = findWorkspaceRoot(folder);
+    if (root.empty())
+        return folderPath;
+    dockerfileName = (folder.lexically_relative(root) / "Dockerfile").generic_string();
+    return root.string();
+}
+
+// Sorted list of what a build actually sends: .dockerignore applied, then narrowed to the Dockerfile's COPY/ADD sources.
+std::vector<ContextEntry> collectContextEntries(const std::string &folderPath, const std::string &dockerfile,
+                                                const std::string &dockerfileName = "Dockerfile") {
+    DockerIgnore ignore(folderPath);
+    auto sources = dockerfileCopySources(dockerfile);
+    bool everything = false;
+    for (const auto &source : sources)
+        everything = everything || source == ".";
+    
+    std::map<std::string, ContextEntry> entries;
+    auto addParents = [&](const std::string &path) {
+        for (size_t pos = path.find('/'); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+            std::string parent = path.substr(0, pos);
+            entries.emplace(parent, ContextEntry{parent, fs::file_type::directory, true});
+        }
+    };
+    
+    fs::path root(folderPath);
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+         it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec)
+            break;
+        std::string rel = it->path().lexically_relative(root).generic_string();
+        auto status = it->symlink_status();
+        if (ignore.excluded(rel)) {
+            if (status.type() == fs::file_type::directory && ignore.canPrune())
+                it.disable_recursion_pending();
+            continue;
+        }
+        bool selected = everything || rel == dockerfileName || rel == ".dockerignore";
+        for (size_t i = 0; !selected && i < sources.size(); ++i)
+            selected = globMatchesOrParent(sources[i], rel);
+        if (!selected)
+            continue;
+        auto type = status.type();
+        if (type != fs::file_type::regular && type != fs::file_type::directory && type != fs::file_type::symlink)
+            continue;
+        bool executable = (status.permissions() & fs::perms::owner_exec) != fs::perms::none;
+        entries[rel] = ContextEntry{rel, type, executable};
+        addParents(rel);
+    }
+    
+    std::vector<ContextEntry> sorted;
+    sorted.reserve(entries.size());
+    for (auto &entry : entries)
+        sorted.push_back(std::move(entry.second));
+    return sorted;
+}
+
+class ByteSink {
+public:
+    virtual void write(const char *data, size_t size) = 0;
+    virtual void finish() {}
+    virtual ~ByteSink() {}
+};
+
+class FileSink : public ByteSink {
+public:
+    explicit FileSink(FILE *out) : out(out) {}
+    
+    void write(const char *data, size_t size) override {
+        if (std::fwrite(data, 1, size, out) != size)
+            throw std::runtime_error("write failed");
+    }
+    
+    void finish() override { std::fflush(out); }
+    
+private:
+    FILE *out;
+};
+
+// pigz-style gzip: fixed-size chunks are deflated in parallel, each primed with the previous chunk's
+// last 32 KiB, and joined into a single member. Chunk boundaries do not depend on the thread count,
+// so the output is byte-identical however many threads run.
+class ParallelGzipSink : public ByteSink {
+public:
+    ParallelGzipSink(ByteSink &out, unsigned threads, int level = 6)
+        : out(out), threads(threads ? threads : 1), level(level) {
+        static const unsigned char header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255};
+        out.write(reinterpret_cast<const char *>(header), sizeof(header));
+        pending.emplace_back();
+        pending.back().reserve(chunkSize);
+    }
+    
+    void write(const char *data, size_t size) override {
+        while (size > 0) {
+            if (pending.back().size() == chunkSize) {
+                if (pending.size() == threads)
+                    flush(false);
+                pending.emplace_back();
+                pending.back().reserve(chunkSize);
+            }
+            size_t take = std::min(size, chunkSize - pending.back().size());
+            pending.back().append(data, take);
+            data += take;
+            size -= take;
+        }
+    }
+    
+    void finish() override {
+        flush(true);
+        unsigned char trailer[8];
+        for (int i = 0; i < 4; ++i) {
+            trailer[i] = static_cast<unsigned char>(crc >> (8 * i));
+            trailer[4 + i] = static_cast<unsigned char>(totalSize >> (8 * i));
+        }
+        out.write(reinterpret_cast<const char *>(trailer), sizeof(trailer));
+        out.finish();
+    }
+    
+private:
+    static constexpr size_t chunkSize = 1 << 20;
+    static constexpr size_t windowSize = 1 << 15;
+    
+    struct Result {
+        std::string compressed;
+        uLong crc = 0;
+    };
+    
+    static Result compressChunk(const std::string &input, const std::string *previous, bool last, int level) {
+        Result result;
+        z_stream zs{};
+        if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("deflateInit2 failed");
+        if (previous && !previous->empty()) {
+            size_t dictSize = std::min(previous->size(), windowSize);
+            deflateSetDictionary(&zs, reinterpret_cast<const Bytef *>(previous->data() + previous->size() - dictSize),
+                                 static_cast<uInt>(dictSize));
+        }
+        result.compressed.resize(deflateBound(&zs, input.size()) + 16);
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+        zs.avail_in = static_cast<uInt>(input.size());
+        zs.next_out = reinterpret_cast<Bytef *>(&result.compressed[0]);
+        zs.avail_out = static_cast<uInt>(result.compressed.size());
+        deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+        result.compressed.resize(result.compressed.size() - zs.avail_out);
+        deflateEnd(&zs);
+        result.crc = crc32(0L, reinterpret_cast<const Bytef *>(input.data()), static_cast<uInt>(input.size()));
+        return result;
+    }
+    
+    void flush(bool last) {
+        std::vector<Result> results(pending.size());
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            const std::string *previous = i == 0 ? &tail : &pending[i - 1];
+            bool isLast = last && i + 1 == pending.size();
+            workers.emplace_back([&, i, previous, isLast] {
+                results[i] = compressChunk(pending[i], previous, isLast, level);
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+        for (size_t i = 0; i < pending.size(); ++i) {
+            out.write(results[i].compressed.data(), results[i].compressed.size());
+            crc = crc32_combine(crc, results[i].crc, static_cast<z_off_t>(pending[i].size()));
+            totalSize += pending[i].size();
+        }
+        const std::string &previous = pending.back();
+        tail = previous.substr(previous.size() > windowSize ? previous.size() - windowSize : 0);
+        pending.clear();
+    }
+    
+    ByteSink &out;
+    unsigned threads;
+    int level;
+    std::vector<std::string> pending;
+    std::string tail;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    uint64_t totalSize = 0;
+};
+
+class TarWriter {
+public:
+    explicit TarWriter(ByteSink &out, long long mtime) : out(out), mtime(mtime) {}
+    
+    void addDirectory(const std::string &name) {
+        writeHeader(name + "/", '5', 0755, 0, "");
+    }
+    
+    void addSymlink(const std::string &name, const std::string &target) {
+        writeHeader(name, '2', 0777, 0, target);
+    }
+    
+    void addFile(const std::string &name, const fs::path &source, bool executable) {
+        OpenFileSlot slot;
+        std::ifstream file(source, std::ios::binary);
+        uintmax_t size = fs::file_size(source);
+        writeHeader(name, '0', executable ? 0755 : 0644, size, "");
+        std::vector<char> buffer(1 << 16);
+        uintmax_t remaining = size;
+        while (remaining > 0 && file) {
+            file.read(buffer.data(), static_cast<std::streamsize>(std::min<uintmax_t>(buffer.size(), remaining)));
+            size_t got = static_cast<size_t>(file.gcount());
+            if (got == 0)
+                break;
+            operatorMetrics.bytesRead.add(got);
+            readThrottle.consume(got);
+            out.write(buffer.data(), got);
+            remaining -= got;
+        }
+        // A file that shrank after stat is zero-filled so the archive stays well-formed.
+        std::fill(buffer.begin(), buffer.end(), 0);
+        while (remaining > 0) {
+            size_t fill = static_cast<size_t>(std::min<uintmax_t>(buffer.size(), remaining));
+            out.write(buffer.data(), fill);
+            remaining -= fill;
+        }
+        pad(size);
+    }
+    
+    void finish() {
+        std::string zeros(1024, '\0');
+        out.write(zeros.data(), zeros.size());
+        out.finish();
+    }
+    
+private:
+    static void octal(char *field, size_t width, unsigned long long value) {
+        for (size_t i = width - 1; i-- > 0; value >>= 3)
+            field[i] = static_cast<char>('0' + (value & 7));
+        field[width - 1] = '\0';
+    }
+    
+    void pad(uintmax_t size) {
+        static const char zeros[512] = {};
+        if (size % 512)
+            out.write(zeros, 512 - size % 512);
+    }
+    
+    void writeRawHeader(const std::string &name, char type, unsigned mode, uintmax_t size,
+                        const std::string &link, const std::string &prefix) {
+        char header[512] = {};
+        std::memcpy(header, name.data(), std::min<size_t>(name.size(), 100));
+        octal(header + 100, 8, mode);
+        octal(header + 108, 8, 0);
+        octal(header + 116, 8, 0);
+        octal(header + 124, 12, size);
+        octal(header + 136, 12, static_cast<unsigned long long>(mtime));
+        std::memset(header + 148, ' ', 8);
+        header[156] = type;
+        std::memcpy(header + 157, link.data(), std::min<size_t>(link.size(), 100));
+        std::memcpy(header + 257, "ustar", 6);
+        std::memcpy(header + 263, "00", 2);
+        std::memcpy(header + 345, prefix.data(), std::min<size_t>(prefix.size(), 155));
+        unsigned checksum = 0;
+        for (unsigned char c : header)
+            checksum += c;
+        std::snprintf(header + 148, 8, "%06o", checksum);
+        out.write(header, sizeof(header));
+    }
+    
+    static std::string paxRecord(const std::string &key, const std::string &value) {
+        size_t length = key.size() + value.size() + 3;
+        size_t total = length + std::to_string(length).size();
+        if (std::to_string(total).size() != std::to_string(length).size())
+            ++total;
+        return std::to_string(total) + " " + key + "=" + value + "\n";
+    }
+    
+    void writeHeader(const std::string &name, char type, unsigned mode, uintmax_t size, const std::string &link) {
+        std::string shortName = name, prefix, pax;
+        if (name.size() > 100) {
+            size_t split = name.find('/', name.size() > 101 ? name.size() - 101 : 0);
+            if (split != std::string::npos && split <= 155 && name.size() - split - 1 <= 100 && split > 0) {
+                prefix = name.substr(0, split);
+                shortName = name.substr(split + 1);
+            } else {
+                pax += paxRecord("path", name);
+                shortName = name.substr(0, 100);
+            }
+        }
+        if (link.size() > 100)
+            pax += paxRecord("linkpath", link);
+        if (size > 077777777777ULL)
+            pax += paxRecord("size", std::to_string(size));
+        if (!pax.empty()) {
+            writeRawHeader("././@PaxHeader", 'x', 0644, pax.size(), "", "");
+            out.write(pax.data(), pax.size());
+            pad(pax.size());
+        }
+        writeRawHeader(shortName, type, mode, size > 077777777777ULL ? 0 : size, link, prefix);
+    }
+    
+    ByteSink &out;
+    long long mtime;
+};
+
+// What the process may really use. In a CI container hardware_concurrency() is the host's core count; the
+// scheduler grants only the cpuset and the cgroup CPU quota (cpu.max on v2, cpu.cfs_quota_us on v1), and the
+// memory limit (memory.max, memory.limit_in_bytes) is what the OOM killer enforces.
+struct ResourceLimits {
+    unsigned hostCpus = 1;
+    unsigned affinityCpus = 0;
+    double quotaCpus = 0;
+    uint64_t memoryLimit = 0;
+    std::string cgroup = "none";
+    std::string cgroupPath;
+};
+
+std::string readFirstLine(const fs::path &path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return trim(line);
+}
+
+ResourceLimits detectResourceLimits() {
+    ResourceLimits limits;
+    limits.hostCpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t affinity;
+    if (sched_getaffinity(0, sizeof(affinity), &affinity) == 0)
+        limits.affinityCpus = static_cast<unsigned>(CPU_COUNT(&affinity));
+    
+    auto tightenCpus = [&](double cpus) {
+        if (cpus > 0 && (limits.quotaCpus == 0 || cpus < limits.quotaCpus))
+            limits.quotaCpus = cpus;
+    };
+    auto tightenMemory = [&](const std::string &text) {
+        uint64_t bytes = std::strtoull(text.c_str(), nullptr, 10);
+        // cgroup v1 reports "unlimited" as a page-rounded LLONG_MAX.
+        if (bytes > 0 && bytes < (1ull << 60) && (limits.memoryLimit == 0 || bytes < limits.memoryLimit))
+            limits.memoryLimit = bytes;
+    };
+    
+    // Lines are hierarchy-id:controllers:path; v2 has the single line "0::<path>".
+    std::ifstream self("/proc/self/cgroup");
+    std::map<std::string, std::string> v1Paths;
+    bool v2 = false;
+    for (std::string line; std::getline(self, line);) {
+        size_t first = line.find(':'), second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos)
+            continue;
+        std::string controllers = line.substr(first + 1, second - first - 1), path = line.substr(second + 1);
+        if (line.compare(0, first, "0") == 0 && controllers.empty()) {
+            v2 = true;
+            limits.cgroupPath = path;
+        }
+        std::istringstream names(controllers);
+        for (std::string name; std::getline(names, name, ',');)
+            v1Paths[name] = path;
+    }
+    
+    if (v2 && fs::exists("/sys/fs/cgroup/cgroup.controllers")) {
+        limits.cgroup = "v2";
+        // Every ancestor's limit applies too. Inside a cgroup namespace the path is "/" and the mount is the container's own.
+        fs::path dir = "/sys/fs/cgroup";
+        auto readLimits = [&](const fs::path &cgroupDir) {
+            std::istringstream cpu(readFirstLine(cgroupDir / "cpu.max"));
+            std::string quota;
+            double period = 0;
+            if (cpu >> quota >> period && quota != "max" && period > 0)
+                tightenCpus(std::atof(quota.c_str()) / period);
+            std::string memory = readFirstLine(cgroupDir / "memory.max");
+            if (!memory.empty() && memory != "max")
+                tightenMemory(memory);
+        };
+        readLimits(dir);
+        for (const auto &part : fs::path(limits.cgroupPath).relative_path()) {
+            dir /= part;
+            readLimits(dir);
+        }
+    } else if (!v1Paths.empty()) {
+        limits.cgroup = "v1";
+        limits.cgroupPath = v1Paths.count("cpu") ? v1Paths["cpu"] : v1Paths.begin()->second;
+        // The controller mount shows either the process's own cgroup (namespaced) or the whole hierarchy.
+        auto controllerDirs = [&](const std::vector<std::string> &mounts, const std::string &controller) {
+            std::vector<fs::path> dirs;
+            for (const auto &mount : mounts) {
+                dirs.push_back(fs::path(mount) / fs::path(v1Paths[controller]).relative_path());
+                dirs.push_back(mount);
+            }
+            return dirs;
+        };
+        for (const auto &dir : controllerDirs({"/sys/fs/cgroup/cpu,cpuacct", "/sys/fs/cgroup/cpu"}, "cpu")) {
+            double quota = std::atof(readFirstLine(dir / "cpu.cfs_quota_us").c_str());
+            double period = std::atof(readFirstLine(dir / "cpu.cfs_period_us").c_str());
+            if (quota > 0 && period > 0) {
+                tightenCpus(quota / period);
+                break;
+            }
+        }
+        for (const auto &dir : controllerDirs({"/sys/fs/cgroup/memory"}, "memory")) {
+            std::string memory = readFirstLine(dir / "memory.limit_in_bytes");
+            if (!memory.empty()) {
+                tightenMemory(memory);
+                break;
+            }
+        }
+    }
+    return limits;
+}
+
+// Thread count and buffer sizes derived from the limits above, or from --threads / --memory-limit.
+struct EffectiveConfig {
+    ResourceLimits limits;
+    unsigned threads = 1;
+    std::string threadsFrom;
+    uint64_t memoryLimit = 0;
+    std::string memoryFrom;
+    size_t gzipChunksInFlight = 1;
+    size_t readBufferSize = 1 << 20;
+};
+
+const EffectiveConfig &effectiveConfig() {
+    static const EffectiveConfig config = [] {
+        EffectiveConfig c;
+        c.limits = detectResourceLimits();
+        c.threads = c.limits.hostCpus;
+        c.threadsFrom = "hardware_concurrency";
+        if (c.limits.affinityCpus > 0 && c.limits.affinityCpus < c.threads) {
+            c.threads = c.limits.affinityCpus;
+            c.threadsFrom = "cpuset";
+        }
+        if (c.limits.quotaCpus > 0 && std::ceil(c.limits.quotaCpus) < c.threads) {
+            c.threads = static_cast<unsigned>(std::max(1.0, std::ceil(c.limits.quotaCpus)));
+            c.threadsFrom = "cgroup " + c.limits.cgroup + " CPU quota";
+        }
+        if (operatorOptions.threads > 0) {
+            c.threads = operatorOptions.threads;
+            c.threadsFrom = "--threads";
+        }
+        c.memoryLimit = c.limits.memoryLimit;
+        c.memoryFrom = c.memoryLimit ? "cgroup " + c.limits.cgroup : "none";
+        if (operatorOptions.memoryLimitSet) {
+            c.memoryLimit = operatorOptions.memoryLimit;
+            c.memoryFrom = "--memory-limit";
+        }
+        // A quarter of the limit goes to compression chunks (input plus output, about 2 MiB each) and read
+        // buffers; the rest is left to the project index and the caller's own process.
+        c.gzipChunksInFlight = c.threads;
+        if (c.memoryLimit > 0) {
+            uint64_t budget = c.memoryLimit / 4;
+            c.gzipChunksInFlight = static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(c.threads, budget / 2 / (2 << 20))));
+            c.readBufferSize = static_cast<size_t>(std::clamp<uint64_t>(budget / 2 / c.threads, 64 << 10, 1 << 20));
+        }
+        return c;
+    }();
+    return config;
+}
+
+unsigned effectiveThreads() {
+    return effectiveConfig().threads;
+}
+
+// `operator config`: what the limits above came to, and why.
+void printEffectiveConfig() {
+    const EffectiveConfig &c = effectiveConfig();
+    char quota[32] = "없음";
+    if (c.limits.quotaCpus > 0)
+        std::snprintf(quota, sizeof(quota), "%.2f", c.limits.quotaCpus);
+    std::cout << "cgroup: " << c.limits.cgroup << (c.limits.cgroupPath.empty() ? "" : " (" + c.limits.cgroupPath + ")") << "\n";
+    std::cout << "CPU: 호스트 " << c.limits.hostCpus << ", cpuset " << c.limits.affinityCpus << ", 할당량 " << quota << "\n";
+    std::cout << "스레드: " << c.threads << " (" << c.threadsFrom << ")\n";
+    std::cout << "메모리 제한: " << (c.memoryLimit ? std::to_string(c.memoryLimit >> 20) + " MiB" : "없음") << " (" << c.memoryFrom << ")\n";
+    std::cout << "gzip 동시 청크: " << c.gzipChunksInFlight << "\n";
+    std::cout << "읽기 버퍼: " << (c.readBufferSize >> 10) << " KiB\n";
+    std::cout << "읽기 대역폭 제한: "
+              << (operatorOptions.readLimit ? std::to_string(operatorOptions.readLimit >> 20) + " MiB/s" : "없음") << "\n";
+    std::cout << "동시에 여는 파일: " << (operatorOptions.maxOpenFiles ? std::to_string(operatorOptions.maxOpenFiles) : "제한 없음")
+              << (operatorOptions.background ? " (--background)" : "") << "\n";
+}
+
+long long sourceDateEpoch() {
+    const char *epoch = std::getenv("SOURCE_DATE_EPOCH");
+    return epoch ? std::atoll(epoch) : 0;
+}
+
+// Writes the context as a tar stream: entries sorted, uid/gid 0, no user names, mtime from
+// SOURCE_DATE_EPOCH (0 by default) and modes reduced to 0644/0755, so identical inputs give identical bytes.
+bool writeBuildContext(const std::string &folderPath, const std::string &output, const std::string &compression) {
+    fs::path dockerfilePath = fs::path(folderPath) / "Dockerfile";
+    std::ifstream dockerfileIn(dockerfilePath);
+    if (!dockerfileIn) {
+        std::cerr << "Dockerfile이 없습니다. 먼저 'operator make " << folderPath << "' 를 실행하세요.\n";
+        return false;
+    }
+    std::string dockerfile((std::istreambuf_iterator<char>(dockerfileIn)), std::istreambuf_iterator<char>());
+    std::string dockerfileName;
+    std::string contextDir = buildContextDir(folderPath, dockerfile, dockerfileName);
+    auto entries = collectContextEntries(contextDir, dockerfile, dockerfileName);
+    
+    bool toStdout = output.empty() || output == "-";
+    FILE *out = nullptr;
+    bool piped = false;
+    if (compression == "zstd") {
+        std::string command = "zstd -q -c -T" + std::to_string(effectiveThreads());
+        if (!toStdout)
+            command += " > " + shellQuote(output);
+        out = popen(command.c_str(), "w");
+        piped = true;
+    } else if (compression == "gzip" || compression == "none") {
+        out = toStdout ? stdout : std::fopen(output.c_str(), "wb");
+    } else {
+        std::cerr << "지원하지 않는 압축 방식입니다: " << compression << " (gzip, zstd, none)\n";
+        return false;
+    }
+    if (!out) {
+        std::cerr << "빌드 컨텍스트를 쓸 수 없습니다: " << output << "\n";
+        return false;
+    }
+    
+    bool ok = true;
+    try {
+        FileSink fileSink(out);
+        std::unique_ptr<ParallelGzipSink> gzipSink;
+        if (compression == "gzip")
+            gzipSink = std::make_unique<ParallelGzipSink>(fileSink, static_cast<unsigned>(effectiveConfig().gzipChunksInFlight));
+        TarWriter tar(gzipSink ? static_cast<ByteSink &>(*gzipSink) : fileSink, sourceDateEpoch());
+        fs::path root(contextDir);
+        for (const auto &entry : entries) {
+            if (entry.type == fs::file_type::directory)
+                tar.addDirectory(entry.path);
+            else if (entry.type == fs::file_type::symlink)
+                tar.addSymlink(entry.path, fs::read_symlink(root / entry.path).generic_string());
+            else
+                tar.addFile(entry.path, root / entry.path, entry.executable);
+        }
+        tar.finish();
+    } catch (const std::exception &e) {
+        std::cerr << "빌드 컨텍스트 생성 실패: " << e.what() << "\n";
+        ok = false;
+    }
+    
+    if (piped)
+        ok = pclose(out) == 0 && ok;
+    else if (!toStdout)
+        std::fclose(out);
+    if (ok)
+        std::cerr << "빌드 컨텍스트: 항목 " << entries.size() << "개 (" << compression << ", 스레드 "
+                  << effectiveThreads() << ")\n";
+    return ok;
+}
+
+struct TemplateContext {
+    std::map<std::string, std::string> values;
+    std::map<std::string, std::vector<std::string>> lists;
+    std::string root;
+};
+
+// A template is compiled once into a flat list of steps; rendering walks the steps with no parsing.
+//   {{name}}                         value (or the space-joined list)
+//   {{#if name}} .. {{else}} .. {{/if}}   also {{#unless name}}; `exists:<path>` tests a project file
+//   {{#each list}} .. {{.}} .. {{/each}}
+//   {{! comment}}
+class Template {
+public:
+    static bool compile(const std::string &source, Template &compiled, std::string &error) {
+        compiled = Template();
+        // After {{else}} the open step is the jump, so the block kind is kept separately for the closer.
+        std::vector<size_t> open;
+        std::vector<Op> openKinds;
+        std::vector<int> openLines;
+        size_t pos = 0;
+        while (pos < source.size()) {
+            size_t start = source.find("{{", pos);
+            if (start == std::string::npos)
+                start = source.size();
+            if (start > pos)
+                compiled.emit(Op::Text, source.substr(pos, start - pos));
+            if (start == source.size())
+                break;
+            size_t close = source.find("}}", start + 2);
+            int line = 1 + static_cast<int>(std::count(source.begin(), source.begin() + static_cast<std::ptrdiff_t>(start), '\n'));
+            if (close == std::string::npos) {
+                error = std::to_string(line) + ": '}}'가 없습니다";
+                return false;
+            }
+            std::string tag = trim(source.substr(start + 2, close - start - 2));
+            pos = close + 2;
+            auto word = [&](size_t prefix) { return trim(tag.substr(prefix)); };
+            if (tag.empty() || tag[0] == '!') {
+                continue;
+            } else if (tag.rfind("#if ", 0) == 0 || tag.rfind("#unless ", 0) == 0 || tag.rfind("#each ", 0) == 0) {
+                Op op = tag[1] == 'i' ? Op::If : tag[1] == 'u' ? Op::Unless : Op::Each;
+                open.push_back(compiled.emit(op, word(tag.find(' '))));
+                openKinds.push_back(op);
+                openLines.push_back(line);
+            } else if (tag == "else") {
+                if (open.empty() || openKinds.back() == Op::Each) {
+                    error = std::to_string(line) + ": {{#if}} 없이 {{else}}가 사용되었습니다";
+                    return false;
+                }
+                size_t jump = compiled.emit(Op::Jump, "");
+                compiled.steps[open.back()].jump = static_cast<uint32_t>(compiled.steps.size());
+                open.back() = jump;
+            } else if (tag == "/if" || tag == "/unless" || tag == "/each") {
+                if (open.empty()) {
+                    error = std::to_string(line) + ": 짝이 맞지 않는 {{" + tag + "}}";
+                    return false;
+                }
+                Op closes = tag == "/if" ? Op::If : tag == "/unless" ? Op::Unless : Op::Each;
+                if (openKinds.back() != closes) {
+                    error = std::to_string(line) + ": 짝이 맞지 않는 {{" + tag + "}}";
+                    return false;
+                }
+                if (closes == Op::Each)
+                    compiled.emit(Op::End, "");
+                compiled.steps[open.back()].jump = static_cast<uint32_t>(compiled.steps.size());
+                open.pop_back();
+                openKinds.pop_back();
+                openLines.pop_back();
+            } else if (tag[0] == '#' || tag[0] == '/') {
+                error = std::to_string(line) + ": 알 수 없는 태그 {{" + tag + "}}";
+                return false;
+            } else {
+                compiled.emit(Op::Var, tag);
+            }
+        }
+        if (!open.empty()) {
+            error = std::to_string(openLines.back()) + ": 닫히지 않은 블록: " + compiled.strings[compiled.steps[open.back()].arg];
+            return false;
+        }
+        return true;
+    }
+    
+    std::string render(const TemplateContext &context) const {
+        std::string out;
+        renderRange(context, 0, steps.size(), nullptr, out);
+        return out;
+    }
+    
+private:
+    enum class Op : uint8_t { Text, Var, If, Unless, Each, Jump, End };
+    
+    struct Step {
+        Op op;
+        uint32_t arg;
+        uint32_t jump;
+    };
+    
+    std::vector<Step> steps;
+    std::vector<std::string> strings;
+    
+    size_t emit(Op op, const std::string &text) {
+        strings.push_back(text);
+        steps.push_back({op, static_cast<uint32_t>(strings.size() - 1), 0});
+        return steps.size() - 1;
+    }
+    
+    static bool truthy(const TemplateContext &context, const std::string &name, const std::string *item) {
+        if (name == ".")
+            return item && !item->empty();
+        if (name.rfind("exists:", 0) == 0)
+            return !context.root.empty() && fs::exists(fs::path(context.root) / name.substr(7));
+        auto list = context.lists.find(name);
+        if (list != context.lists.end())
+            return !list->second.empty();
+        auto value = context.values.find(name);
+        return value != context.values.end() && !value->second.empty() && value->second != "false" && value->second != "0";
+    }
+    
+    void renderRange(const TemplateContext &context, size_t begin, size_t end, const std::string *item, std::string &out) const {
+        for (size_t i = begin; i < end;) {
+            const Step &step = steps[i];
+            const std::string &text = strings[step.arg];
+            switch (step.op) {
+                case Op::Text:
+                    out += text;
+                    ++i;
+                    break;
+                case Op::Var:
+                    if (text == ".") {
+                        if (item)
+                            out += *item;
+                    } else if (context.values.count(text)) {
+                        out += context.values.at(text);
+                    } else if (context.lists.count(text)) {
+                        const auto &list = context.lists.at(text);
+                        for (size_t k = 0; k < list.size(); ++k)
+                            out += (k ? " " : "") + list[k];
+                    }
+                    ++i;
+                    break;
+                case Op::If:
+                case Op::Unless:
+                    i = truthy(context, text, item) == (step.op == Op::If) ? i + 1 : step.jump;
+                    break;
+                case Op::Each: {
+                    auto list = context.lists.find(text);
+                    if (list != context.lists.end())
+                        for (const auto &element : list->second)
+                            renderRange(context, i + 1, step.jump - 1, &element, out);
+                    i = step.jump;
+                    break;
+                }
+                case Op::Jump:
+                    i = step.jump;
+                    break;
+                case Op::End:
+                    ++i;
+                    break;
+            }
+        }
+    }
+};
+
+std::string imageRepository(const std::string &image) {
+    std::string repo = image.substr(0, image.find('@'));
+    size_t slash = repo.rfind('/');
+    size_t colon = repo.rfind(':');
+    if (colon != std::string::npos && (slash == std::string::npos || colon > slash))
+        repo = repo.substr(0, colon);
+    for (const char *prefix : {"docker.io/library/", "docker.io/", "library/"})
+        if (repo.rfind(prefix, 0) == 0)
+            repo = repo.substr(std::strlen(prefix));
+    return repo;
+}
+
+std::string imageTag(const std::string &image) {
+    std::string name = image.substr(0, image.find('@'));
+    size_t slash = name.rfind('/');
+    size_t colon = name.rfind(':');
+    if (colon == std::string::npos || (slash != std::string::npos && colon < slash))
+        return "";
+    return name.substr(colon + 1);
+}
+
+std::vector<fs::path> templateDirs() {
+    std::vector<fs::path> bases;
+    if (const char *paths = std::getenv("OPERATOR_TEMPLATE_PATH")) {
+        std::istringstream in(paths);
+        std::string dir;
+        while (std::getline(in, dir, ':'))
+            if (!dir.empty())
+                bases.push_back(dir);
+    }
+    if (const char *xdg = std::getenv("XDG_CONFIG_HOME"))
+        bases.push_back(fs::path(xdg) / "operator" / "templates");
+    else if (const char *home = std::getenv("HOME"))
+        bases.push_back(fs::path(home) / ".config" / "operator" / "templates");
+    bases.push_back("templates");
+    std::vector<fs::path> dirs;
+    for (const auto &base : bases) {
+        if (!operatorOptions.org.empty())
+            dirs.push_back(base / operatorOptions.org);
+        dirs.push_back(base);
+    }
+    return dirs;
+}
+
+std::string templateSlug(const std::string &name) {
+    std::string slug;
+    for (char c : name) {
+        if (std::isalnum(static_cast<unsigned char>(c)))
+            slug += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        else if (c == '+')
+            slug += 'p';
+        else if (c == '#')
+            slug += "sharp";
+        else if (!slug.empty() && slug.back() != '-')
+            slug += '-';
+    }
+    while (!slug.empty() && slug.back() == '-')
+        slug.pop_back();
+    return slug;
+}
+
+// Looks templates up by file name through templateDirs(); the first match wins, so an organization's
+// directory overrides the shared one. Each file is read and compiled at most once per process.
+class TemplateLibrary {
+public:
+    const Template *find(const std::string &fileName) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto cached = compiled.find(fileName);
+        if (cached != compiled.end())
+            return cached->second.get();
+        std::unique_ptr<Template> result;
+        for (const auto &dir : templateDirs()) {
+            fs::path path = dir / fileName;
+            std::ifstream in(path);
+            if (!in)
+                continue;
+            std::string source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            result.reset(new Template());
+            std::string error;
+            if (!Template::compile(source, *result, error)) {
+                std::cerr << "템플릿 오류: " << path.string() << ":" << error << "\n";
+                result.reset();
+            }
+            break;
+        }
+        return (compiled[fileName] = std::move(result)).get();
+    }
+    
+    // `images` maps base images to replacements, one `pattern = template` per line, e.g.
+    //   python:* = registry.example.com/mirror/python:{{tag}}
+    const std::vector<std::pair<std::string, Template>> &imageRules() {
+        std::call_once(imagesLoaded, [this] {
+            for (const auto &dir : templateDirs()) {
+                std::ifstream in(dir / "images");
+                if (!in)
+                    continue;
+                std::string line;
+                int lineNumber = 0;
+                while (std::getline(in, line)) {
+                    ++lineNumber;
+                    line = trim(line);
+                    size_t eq = line.find('=');
+                    if (line.empty() || line[0] == '#')
+                        continue;
+                    Template replacement;
+                    std::string error = eq == std::string::npos ? "'패턴 = 이미지' 형식이 아닙니다" : "";
+                    if (error.empty() && Template::compile(trim(line.substr(eq + 1)), replacement, error))
+                        images.emplace_back(trim(line.substr(0, eq)), std::move(replacement));
+                    else
+                        std::cerr << "템플릿 오류: " << (dir / "images").string() << ":" << lineNumber << ": " << error << "\n";
+                }
+                break;
+            }
+        });
+        return images;
+    }
+    
+private:
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Template>> compiled;
+    std::once_flag imagesLoaded;
+    std::vector<std::pair<std::string, Template>> images;
+};
+
+TemplateLibrary &templateLibrary() {
+    static TemplateLibrary library;
+    return library;
+}
+
+TemplateContext projectTemplateContext(const std::string &folderPath, const std::string &language,
+                                       const std::set<std::string> &deps) {
+    TemplateContext context;
+    context.root = folderPath;
+    context.values["language"] = language;
+    context.values["project"] = fs::absolute(folderPath).lexically_normal().filename().string();
+    context.values["org"] = operatorOptions.org;
+    context.values["offline"] = operatorOptions.offline ? "true" : "";
+    context.lists["deps"] = std::vector<std::string>(deps.begin(), deps.end());
+    return context;
+}
+
+// Organization overrides, applied to whatever the handlers emitted:
+//   <language>.Dockerfile.tmpl  replaces a handler's output; {{default}} is the built-in Dockerfile
+//   stage.tmpl                  instructions inserted after every FROM (labels, mirrors, proxies)
+//   images                      base image rewrites
+void emitWithTemplates(DockerfileIR &docker, LanguageHandler &handler, const std::string &folderPath,
+                       const std::set<std::string> &deps) {
+    TemplateLibrary &library = templateLibrary();
+    DockerfileIR own;
+    handler.emitDockerfile(own, folderPath, deps);
+    if (!own.stages.empty()) {
+        handler.emitTestStage(own, folderPath);
+        DockerfileIR dev;
+        DevService service;
+        if (handler.emitDevStage(dev, service, folderPath) && dev.stages.size() == 1) {
+            dev.stages[0].name = service.stage = "dev";
+            service.name = templateSlug(handler.getName());
+            own.stages.insert(own.stages.end() - 1, dev.stages[0]);
+            own.devServices.push_back(service);
+        }
+    }
+    docker.generatedFiles.insert(own.generatedFiles.begin(), own.generatedFiles.end());
+    TemplateContext context = projectTemplateContext(folderPath, handler.getName(), deps);
+    
+    if (const Template *replacement = library.find(templateSlug(handler.getName()) + ".Dockerfile.tmpl")) {
+        context.values["default"] = own.render();
+        DockerfileIR rendered = parseDockerfile(replacement->render(context));
+        // RUNs kept from {{default}} get back the install inputs the ordering pass hoists; the dev service
+        // survives as long as its stage does.
+        for (auto &stage : rendered.stages) {
+            for (auto &instruction : stage.instructions) {
+                if (instruction.op != DockerOp::Run)
+                    continue;
+                for (const auto &original : own.stages) {
+                    if (!stage.name.empty() && original.name != stage.name)
+                        continue;
+                    for (const auto &candidate : original.instructions)
+                        if (candidate.op == DockerOp::Run && candidate.commands == instruction.commands)
+                            instruction.inputs = candidate.inputs;
+                }
+            }
+        }
+        for (const auto &service : own.devServices) {
+            if (hasStage(rendered, service.stage))
+                rendered.devServices.push_back(service);
+            else
+                std::cerr << templateSlug(handler.getName()) << ".Dockerfile.tmpl에 '" << service.stage
+                          << "' 스테이지가 없어 compose.dev.yaml을 만들지 않습니다.\n";
+        }
+        own = std::move(rendered);
+    }
+    
+    const Template *stageTemplate = library.find("stage.tmpl");
+    static const std::regex testStage("(.*-)?test");
+    for (auto it = own.stages.begin(); it != own.stages.end(); ++it) {
+        auto &stage = *it;
+        // `FROM <earlier stage>` is not a base image: neither image rules nor stage.tmpl apply to it again.
+        bool stageReference = std::any_of(own.stages.begin(), it, [&](const DockerStage &s) { return s.name == stage.image; });
+        if (stageReference)
+            continue;
+        for (const auto &rule : library.imageRules()) {
+            if (!globMatch(rule.first.c_str(), stage.image.c_str()))
+                continue;
+            TemplateContext imageContext = context;
+            imageContext.values["image"] = stage.image;
+            imageContext.values["repository"] = imageRepository(stage.image);
+            imageContext.values["tag"] = imageTag(stage.image);
+            stage.image = trim(rule.second.render(imageContext));
+            break;
+        }
+        if (stageTemplate && stage.image != "scratch" && !std::regex_match(stage.name, testStage)) {
+            TemplateContext stageContext = context;
+            stageContext.values["image"] = stage.image;
+            stageContext.values["stage"] = stage.name;
+            auto inserted = parseDockerfile("FROM scratch\n" + stageTemplate->render(stageContext));
+            auto &added = inserted.stages.front().instructions;
+            stage.instructions.insert(stage.instructions.begin(), added.begin(), added.end());
+        }
+    }
+    for (const auto &line : own.preamble)
+        if (std::find(docker.preamble.begin(), docker.preamble.end(), line) == docker.preamble.end())
+            docker.preamble.push_back(line);
+    // Several languages in one Dockerfile: stage names another language already used get its prefix.
+    for (auto &stage : own.stages) {
+        if (stage.name.empty() || !hasStage(docker, stage.name))
+            continue;
+        std::string renamed = templateSlug(handler.getName()) + "-" + stage.name;
+        for (auto &other : own.stages) {
+            if (other.image == stage.name)
+                other.image = renamed;
+            for (auto &instruction : other.instructions)
+                for (auto &flag : instruction.flags)
+                    if (flag == "--from=" + stage.name)
+                        flag = "--from=" + renamed;
+        }
+        for (auto &service : own.devServices)
+            if (service.stage == stage.name)
+                service.stage = renamed;
+        stage.name = renamed;
+    }
+    docker.stages.insert(docker.stages.end(), own.stages.begin(), own.stages.end());
+    docker.devServices.insert(docker.devServices.end(), own.devServices.begin(), own.devServices.end());
+}
+
+void displayBanner() {
+    std::cout << R"(               
+    ____ ______   ________________ _/  |_  ___________ 
+   /  _ \\____ \_/ __ \_  __ \__  \\   __\/  _ \_  __ \
+  (  <_> )  |_> >  ___/|  | \// __ \|  | (  <_> )  | \/
+   \____/|   __/ \___  >__|  (____  /__|  \____/|__|   
+         |__|        \/           \/                   
+  
+  developed by seoyulh92
+  MIT License
+  0.0.1
+)" << "\n";
+}
+
+std::string promptLine(const std::string &prompt) {
+    std::cout << prompt;
+    std::string value;
+    std::getline(std::cin, value);
+    return trim(value);
+}
+
+void addNewLanguage() {
+    std::cin.ignore();
+    std::cout << "\n새 언어 정의를 만듭니다. 비워 둔 항목은 생략됩니다.\n";
+    LanguageDefinition def;
+    def.name = promptLine("언어 이름: ");
+    if (def.name.empty()) {
+        std::cout << "입력값이 없습니다.\n";
+        return;
+    }
+    std::string extensions = promptLine("파일 확장자 (예: .ex .exs): ");
+    std::string manifests = promptLine("매니페스트 파일 (예: mix.exs): ");
+    std::string importPattern = promptLine("import 정규식 (캡처 그룹 1개): ");
+    std::string baseImage = promptLine("베이스 이미지 (예: elixir:1.16): ");
+    std::string install = promptLine("의존성 설치 명령: ");
+    std::string build = promptLine("빌드 명령: ");
+    std::string run = promptLine("실행 명령: ");
+    
+    std::string slug;
+    for (char c : lowercase(def.name))
+        slug += std::isalnum(static_cast<unsigned char>(c)) ? c : '-';
+    fs::path langFilePath = fs::path("languages") / (slug + ".lang");
+    if (fs::exists(langFilePath)) {
+        std::cerr << "이미 존재하는 언어 정의입니다: " << langFilePath.string() << "\n";
+        return;
+    }
+    std::error_code ec;
+    fs::create_directories(langFilePath.parent_path(), ec);
+    std::ofstream out(langFilePath);
+    if (!out.is_open()) {
+        std::cerr << langFilePath.string() << " 파일에 접근할 수 없습니다.\n";
+        return;
+    }
+    out << "name = " << def.name << "\n";
+    const std::pair<const char *, std::string> fields[] = {
+        {"extensions", extensions}, {"manifests", manifests}, {"import", importPattern},
+        {"base_image", baseImage}, {"install", install}, {"build", build}, {"run", run}};
+    for (const auto &field : fields)
+        if (!field.second.empty())
+            out << field.first << " = " << field.second << "\n";
+    out.close();
+    
+    std::vector<std::string> errors;
+    if (!parseLanguageDefinition(langFilePath, def, errors)) {
+        for (const auto &error : errors)
+            std::cerr << "  " << error << "\n";
+        fs::remove(langFilePath, ec);
+        std::cerr << "언어 정의가 올바르지 않아 저장하지 않았습니다.\n";
+        return;
+    }
+    std::cout << "새로운 언어가 추가되었습니다: " << def.name << " (" << fs::absolute(langFilePath).string() << ")\n";
+}
+
+void listLanguages() {
+    std::cout << "기본 지원 언어:\n";
+    for (const char *name : {"Python", "Node.js", "Java", "Ruby", "PHP", "Go", "C# (.NET)", "C++", "Rust"})
+        std::cout << "  - " << name << "\n";
+    const auto &loaded = loadLanguageDefinitions();
+    std::cout << "정의 파일로 추가된 언어:\n";
+    if (loaded.definitions.empty())
+        std::cout << "  없음\n";
+    for (const auto &def : loaded.definitions)
+        std::cout << "  - " << def.name << " (" << def.source << ")\n";
+    for (const auto &error : loaded.errors)
+        std::cerr << "  [오류] " << error << "\n";
+    const auto &plugins = loadPlugins();
+    std::cout << "플러그인 (ABI " << OPERATOR_PLUGIN_ABI_VERSION << "):\n";
+    if (plugins.plugins.empty())
+        std::cout << "  없음\n";
+    for (const auto &plugin : plugins.plugins)
+        std::cout << "  - " << plugin.second->name << " (" << plugin.first << ")\n";
+    for (const auto &error : plugins.errors)
+        std::cerr << "  [오류] " << error << "\n";
+}
+
+std::string promptFolderPath() {
+    std::cout << "\n==== Operator ====\n";
+    std::cout << "프로젝트 폴더 경로를 입력하세요: ";
+    std::string folderPath;
+    std::cin.ignore();
+    std::getline(std::cin, folderPath);
+    
+    while (!fs::exists(folderPath) || !fs::is_directory(folderPath)) {
+        std::cout << "유효하지 않은 폴더입니다. 다시 입력하세요: ";
+        std::getline(std::cin, folderPath);
+    }
+    return folderPath;
+}
+
+bool runVendorStep(const std::string &description, const std::string &command) {
+    std::cout << "[vendor] " << description << std::endl;
+    int status = std::system(command.c_str());
+    if (status != 0)
+        std::cerr << "  실패했습니다 (exit " << status << "): " << command << "\n";
+    return status == 0;
+}
+
+void prepareVendorCache(const std::string &folderPath) {
+    fs::path root = fs::absolute(folderPath);
+    fs::path cache = root / vendorDir;
+    fs::create_directories(cache);
+    std::string cd = "cd " + shellQuote(root.string()) + " && ";
+    int prepared = 0, failed = 0;
+    auto step = [&](const std::string &description, const std::string &command) {
+        if (runVendorStep(description, cd + command))
+            ++prepared;
+        else
+            ++failed;
+    };
+    
+    if (fileExistsInFolder(folderPath, "requirements.txt")) {
+        std::string wheelhouse = shellQuote((cache / "wheelhouse").string());
+        // The test stage installs pytest from here when requirements.txt does not list it.
+        std::string tools = hasPythonTests(folderPath) ? " pytest" : "";
+        step("pip wheelhouse",
+             "(python3 -m pip download --dest " + wheelhouse + " --only-binary=:all: --platform manylinux2014_x86_64"
+             " --python-version 3.9 --implementation cp -r requirements.txt setuptools wheel" + tools +
+             " || python3 -m pip download --dest " + wheelhouse + " -r requirements.txt setuptools wheel" + tools + ")");
+    }
+    if (fileExistsInFolder(folderPath, "pnpm-lock.yaml")) {
+        step("pnpm store", "pnpm fetch --store-dir " + shellQuote((cache / "pnpm-store").string()) +
+             " && npm cache add pnpm --cache " + shellQuote((cache / "npm-cache").string()));
+    } else if (fileExistsInFolder(folderPath, "package-lock.json")) {
+        // npm ci into a staging prefix fills the cache without touching the project's node_modules.
+        std::string staging = shellQuote((cache / ".npm-staging").string());
+        step("npm offline mirror",
+             "mkdir -p " + staging + " && cp package.json package-lock.json " + staging +
+             " && npm ci --ignore-scripts --cache " + shellQuote((cache / "npm-cache").string()) + " --prefix " + staging +
+             " ; status=$? ; rm -rf " + staging + " ; exit $status");
+    }
+    if (fileExistsInFolder(folderPath, "go.mod"))
+        step("go mod vendor", "go mod vendor");
+    if (fileExistsInFolder(folderPath, "Cargo.toml")) {
+        std::ofstream config(cache / "cargo-config.toml");
+        config << "[source.crates-io]\n";
+        config << "replace-with = \"vendored-sources\"\n\n";
+        config << "[source.vendored-sources]\n";
+        config << "directory = \"/app/" << vendorDir << "/cargo\"\n";
+        config.close();
+        step("cargo vendor", "cargo vendor --locked " + shellQuote((cache / "cargo").string()) + " > /dev/null");
+    }
+    if (fileExistsInFolder(folderPath, "pom.xml"))
+        step("maven repository", "mvn -q dependency:go-offline -Dmaven.repo.local=" + shellQuote((cache / "m2").string()));
+    if (fileExistsInFolder(folderPath, "Gemfile"))
+        step("bundle cache", "bundle cache --all");
+    
+    if (prepared + failed == 0) {
+        std::cout << "오프라인 캐시를 만들 lock/manifest 파일이 없습니다.\n";
+        return;
+    }
+    std::cout << "\n오프라인 캐시 준비 완료: " << prepared << "개 성공, " << failed << "개 실패 (" << cache.string() << ")\n";
+    std::cout << "'operator make --offline " << folderPath << "' 로 네트워크 없이 빌드되는 Dockerfile을 생성하세요.\n";
+}
+
+std::vector<std::unique_ptr<LanguageHandler>> createHandlers() {
     std::vector<std::unique_ptr<LanguageHandler>> handlers;
     handlers.push_back(std::make_unique<PythonHandler>());
     handlers.push_back(std::make_unique<NodeHandler>());
@@ -487,69 +5152,2134 @@ void makeDockerfileOperation() {
     handlers.push_back(std::make_unique<CSharpHandler>());
     handlers.push_back(std::make_unique<CppHandler>());
     handlers.push_back(std::make_unique<RustHandler>());
+    for (const auto &def : loadLanguageDefinitions().definitions)
+        handlers.push_back(std::make_unique<DeclarativeHandler>(def));
+    for (const auto &plugin : loadPlugins().plugins)
+        handlers.push_back(std::make_unique<PluginHandler>(plugin.second));
+    return handlers;
+}
+
+// `docker compose -f compose.dev.yaml up --build`: each language's dev stage with the project bind-mounted,
+// so edits reach the running reloader without an image build.
+std::string renderDevCompose(const std::vector<DevService> &services) {
+    std::string yaml = "services:\n";
+    for (const auto &service : services) {
+        yaml += "  " + service.name + ":\n";
+        yaml += "    build:\n      context: .\n      target: " + service.stage + "\n";
+        yaml += "    volumes:\n      - .:" + service.workdir + "\n";
+        for (const auto &volume : service.volumes)
+            yaml += "      - " + volume + "\n";
+        if (!service.ports.empty()) {
+            yaml += "    ports:\n";
+            for (const auto &port : service.ports)
+                yaml += "      - \"" + port + "\"\n";
+        }
+    }
+    return yaml;
+}
+
+std::string renderDockerfile(const std::string &folderPath, std::ostream &log,
+                             std::map<std::string, std::string> *generatedFiles = nullptr) {
+    using Clock = std::chrono::steady_clock;
+    eventStream.emit("scan_started", {{"folder", jsonString(fs::absolute(folderPath).lexically_normal().string())}});
+    auto phaseStart = Clock::now();
+    size_t fileCount = projectIndex(folderPath).fileCount();
+    eventStream.phase("scan", phaseStart, {{"files", std::to_string(fileCount)}});
+    
+    phaseStart = Clock::now();
+    auto handlers = createHandlers();
+    
+    std::vector<LanguageHandler*> candidates;
+    for (auto &handler : handlers) {
+        if (handler->detect(folderPath)) {
+            candidates.push_back(handler.get());
+            if (eventStream.enabled()) {
+                double score = detectionScore(*handler, folderPath);
+                char scoreText[16];
+                std::snprintf(scoreText, sizeof(scoreText), "%.3f", score);
+                eventStream.emit("language_detected", {{"language", jsonString(handler->getName())},
+                                                       {"score", score < 0 ? "null" : scoreText}});
+            }
+        }
+    }
+    eventStream.phase("detect", phaseStart, {{"languages", std::to_string(candidates.size())}});
+    
+    if (candidates.empty())
+        return "";
+    
+    DockerfileIR docker;
+    if (operatorOptions.offline)
+        docker.preamble.push_back("# syntax=docker/dockerfile:1");
+    
+    // Extracts one language's dependencies, reporting each with the manifest it came from.
+    auto extract = [&](LanguageHandler &handler) {
+        auto extractStart = Clock::now();
+        auto dependencies = handler.extractDependencies(folderPath);
+        eventStream.phase("extract", extractStart, {{"language", jsonString(handler.getName())}});
+        if (eventStream.enabled()) {
+            for (const auto &dep : dependencies)
+                eventStream.emit("dependency_found", {{"language", jsonString(handler.getName())},
+                                                      {"name", jsonString(dep)},
+                                                      {"source", jsonString(dependencySource(handler, folderPath, dep))}});
+        }
+        return dependencies;
+    };
+    auto generate = [&](LanguageHandler &handler, const std::set<std::string> &dependencies) {
+        auto generateStart = Clock::now();
+        emitWithTemplates(docker, handler, folderPath, dependencies);
+        eventStream.phase("generate", generateStart, {{"language", jsonString(handler.getName())}});
+    };
+    
+    if (candidates.size() == 1) {
+        auto handler = candidates[0];
+        log << "감지된 언어: " << handler->getName() << "\n";
+        auto dependencies = extract(*handler);
+        if (!dependencies.empty()) {
+            log << "\n=== 감지된 라이브러리 (" << handler->getName() << ") ===\n";
+            for (const auto &dep : dependencies)
+                log << "  - " << dep << "\n";
+            log << "===========================\n\n";
+        } else {
+            log << "\n자동 감지된 라이브러리가 없습니다 (" << handler->getName() << ").\n\n";
+        }
+        generate(*handler, dependencies);
+    } else {
+        log << "여러 언어가 감지되었습니다. 모든 언어에 대한 Dockerfile 내용을 생성합니다.\n";
+        for (auto handler : candidates) {
+            auto dependencies = extract(*handler);
+            log << "\n[" << handler->getName() << "] 감지된 라이브러리:\n";
+            if (!dependencies.empty()) {
+                for (const auto &dep : dependencies)
+                    log << "  - " << dep << "\n";
+            } else {
+                log << "  없음\n";
+            }
+            size_t firstStage = docker.stages.size();
+            generate(*handler, dependencies);
+            if (firstStage < docker.stages.size())
+                docker.stages[firstStage].comment = "===== " + handler->getName() + " Stage =====";
+        }
+    }
+    if (docker.stages.empty())
+        return "";
+    phaseStart = Clock::now();
+    optimizeDockerfile(docker);
+    eventStream.phase("optimize", phaseStart, {{"stages", std::to_string(docker.stages.size())}});
+    if (!docker.devServices.empty())
+        docker.generatedFiles[(fs::path(folderPath) / "compose.dev.yaml").string()] = renderDevCompose(docker.devServices);
+    if (generatedFiles)
+        *generatedFiles = docker.generatedFiles;
+    return docker.render();
+}
+
+// One multi-platform target plus one target per platform: `docker buildx bake` pushes a single
+// manifest list, `docker buildx bake linux-arm64` builds just that architecture.
+void writeBakeFile(const std::string &folderPath) {
+    std::string project = fs::absolute(folderPath).lexically_normal().filename().string();
+    std::string platforms;
+    for (const auto &platform : operatorOptions.platforms)
+        platforms += (platforms.empty() ? "" : ", ") + jsonString(platform);
+    
+    std::string bake;
+    bake += "variable \"TAG\" {\n  default = \"" + project + ":latest\"\n}\n\n";
+    bake += "group \"default\" {\n  targets = [\"image\"]\n}\n\n";
+    bake += "target \"image\" {\n  context = \".\"\n  dockerfile = \"Dockerfile\"\n  tags = [TAG]\n";
+    bake += "  platforms = [" + platforms + "]\n}\n";
+    for (const auto &platform : operatorOptions.platforms) {
+        std::string name = platform;
+        std::replace(name.begin(), name.end(), '/', '-');
+        bake += "\ntarget \"" + name + "\" {\n  inherits = [\"image\"]\n  platforms = [" + jsonString(platform) + "]\n}\n";
+    }
+    
+    fs::path bakePath = fs::path(folderPath) / "docker-bake.hcl";
+    std::ofstream out(bakePath);
+    if (!out) {
+        std::cerr << "docker-bake.hcl을 생성하지 못했습니다.\n";
+        return;
+    }
+    out << bake;
+    std::cout << "docker-bake.hcl이 생성되었습니다: " << bakePath.string() << " (docker buildx bake)\n";
+}
+
+void makeDockerfile(const std::string &folderPath) {
+    std::map<std::string, std::string> generatedFiles;
+    std::string dockerContent = renderDockerfile(folderPath, std::cout, &generatedFiles);
+    if (dockerContent.empty()) {
+        std::cerr << "지원하는 언어가 감지되지 않았습니다. (Unsupported project)\n";
+        eventStream.emit("finished", {{"status", "\"unsupported\""}});
+        return;
+    }
+    auto writeStart = std::chrono::steady_clock::now();
+    for (const auto &file : generatedFiles) {
+        std::error_code ec;
+        fs::create_directories(fs::path(file.first).parent_path(), ec);
+        std::ofstream out(file.first, std::ios::binary);
+        if (!out) {
+            std::cerr << "파일을 생성하지 못했습니다: " << file.first << "\n";
+            eventStream.emit("finished", {{"status", "\"error\""}, {"path", jsonString(file.first)}});
+            return;
+        }
+        out << file.second;
+        std::cout << "빌드 컨텍스트 파일이 생성되었습니다: " << file.first << "\n";
+        eventStream.emit("file_written", {{"path", jsonString(file.first)}, {"bytes", std::to_string(file.second.size())}});
+    }
+    
+    fs::path dockerfilePath = fs::path(folderPath) / "Dockerfile";
+    std::ofstream outFile(dockerfilePath);
+    if (!outFile) {
+        std::cerr << "Dockerfile을 생성하지 못했습니다.\n";
+        eventStream.emit("finished", {{"status", "\"error\""}, {"path", jsonString(dockerfilePath.string())}});
+        return;
+    }
+    outFile << dockerContent;
+    outFile.close();
+    
+    std::cout << "Dockerfile이 생성되었습니다: " << dockerfilePath.string() << "\n";
+    eventStream.emit("file_written", {{"path", jsonString(dockerfilePath.string())}, {"bytes", std::to_string(dockerContent.size())}});
+    if (!operatorOptions.platforms.empty())
+        writeBakeFile(folderPath);
+    eventStream.phase("write", writeStart);
+    eventStream.emit("finished", {{"status", "\"ok\""}});
+    std::cout << "\nOperator 프로세스가 완료되었습니다. 해당 프로젝트는 Docker 컨테이너에서 실행될 준비가 되었습니다!\n";
+}
+
+struct Hash128 {
+    uint64_t high = 0;
+    uint64_t low = 0;
+    
+    std::string hex() const {
+        char text[33];
+        std::snprintf(text, sizeof(text), "%016llx%016llx", static_cast<unsigned long long>(high),
+                      static_cast<unsigned long long>(low));
+        return text;
+    }
+};
+
+// splitmix64 output, fixed at compile time so fingerprints never change between builds of Operator.
+struct HashSecret {
+    uint64_t words[32];
+    constexpr HashSecret() : words() {
+        uint64_t state = 0x6F70657261746F72ULL;
+        for (auto &word : words) {
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+};
+
+constexpr HashSecret hashSecret{};
+
+// XXH3-style streaming hash: eight independent 64-bit lanes fed with 32x32->64 multiplies over
+// 64-byte stripes. The lane loop has no cross-iteration dependency, so GCC/Clang vectorize it
+// (pmuludq on SSE2/AVX2) at -O2 and above. Used only for fingerprints, never for security.
+class FastHasher {
+public:
+    explicit FastHasher(uint64_t seed = 0) {
+        static const uint64_t init[lanes] = {0x9E3779B1ULL, 0x9E3779B185EBCA87ULL, 0xC2B2AE3D27D4EB4FULL,
+                                             0x165667B19E3779F9ULL, 0x85EBCA77C2B2AE63ULL, 0x85EBCA77ULL,
+                                             0x27D4EB2F165667C5ULL, 0xC2B2AE3DULL};
+        for (size_t i = 0; i < lanes; ++i)
+            acc[i] = init[i] ^ seed;
+    }
+    
+    void update(const void *data, size_t size) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        total += size;
+        if (buffered) {
+            size_t take = std::min(size, stripeSize - buffered);
+            std::memcpy(buffer + buffered, p, take);
+            buffered += take;
+            p += take;
+            size -= take;
+            if (buffered < stripeSize)
+                return;
+            consume(buffer);
+            buffered = 0;
+        }
+        for (; size >= stripeSize; p += stripeSize, size -= stripeSize)
+            consume(p);
+        std::memcpy(buffer, p, size);
+        buffered = size;
+    }
+    
+    Hash128 digest() const {
+        FastHasher last = *this;
+        if (last.buffered) {
+            std::memset(last.buffer + last.buffered, 0, stripeSize - last.buffered);
+            last.consume(last.buffer);
+        }
+        Hash128 result;
+        result.low = last.merge(0, total * 0x9E3779B185EBCA87ULL);
+        result.high = last.merge(lanes, ~(total * 0xC2B2AE3D27D4EB4FULL));
+        return result;
+    }
+    
+    static Hash128 of(const std::string &text) {
+        FastHasher hasher;
+        hasher.update(text.data(), text.size());
+        return hasher.digest();
+    }
+    
+private:
+    static constexpr size_t lanes = 8;
+    static constexpr size_t stripeSize = 64;
+    static constexpr size_t stripesPerBlock = 16;
+    
+    static uint64_t load64(const unsigned char *p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    
+    static uint64_t mulFold64(uint64_t a, uint64_t b) {
+        uint64_t aLo = a & 0xFFFFFFFFULL, aHi = a >> 32, bLo = b & 0xFFFFFFFFULL, bHi = b >> 32;
+        uint64_t loLo = aLo * bLo, hiLo = aHi * bLo, loHi = aLo * bHi, hiHi = aHi * bHi;
+        uint64_t cross = (loLo >> 32) + (hiLo & 0xFFFFFFFFULL) + loHi;
+        uint64_t upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+        uint64_t lower = (cross << 32) | (loLo & 0xFFFFFFFFULL);
+        return upper ^ lower;
+    }
+    
+    static uint64_t avalanche(uint64_t h) {
+        h ^= h >> 37;
+        h *= 0x165667919E3779F9ULL;
+        return h ^ (h >> 32);
+    }
+    
+    void consume(const unsigned char *stripe) {
+        const uint64_t *key = hashSecret.words + stripes;
+        for (size_t i = 0; i < lanes; ++i) {
+            uint64_t value = load64(stripe + 8 * i);
+            uint64_t keyed = value ^ key[i];
+            acc[i ^ 1] += value;
+            acc[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+        }
+        if (++stripes == stripesPerBlock) {
+            const uint64_t *scrambleKey = hashSecret.words + stripesPerBlock;
+            for (size_t i = 0; i < lanes; ++i) {
+                acc[i] ^= acc[i] >> 47;
+                acc[i] ^= scrambleKey[i];
+                acc[i] *= 0x9E3779B1ULL;
+            }
+            stripes = 0;
+        }
+    }
+    
+    uint64_t merge(size_t keyOffset, uint64_t start) const {
+        uint64_t result = start;
+        for (size_t i = 0; i < lanes; i += 2)
+            result += mulFold64(acc[i] ^ hashSecret.words[keyOffset + i], acc[i + 1] ^ hashSecret.words[keyOffset + i + 1]);
+        return avalanche(result);
+    }
+    
+    uint64_t acc[lanes];
+    unsigned char buffer[stripeSize];
+    size_t buffered = 0;
+    size_t stripes = 0;
+    uint64_t total = 0;
+};
+
+bool hashFile(const fs::path &path, Hash128 &out) {
+    OpenFileSlot slot;
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    FastHasher hasher;
+    std::vector<char> buffer(effectiveConfig().readBufferSize);
+    size_t got;
+    while ((got = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+        hasher.update(buffer.data(), got);
+        operatorMetrics.bytesRead.add(got);
+        readThrottle.consume(got);
+    }
+    bool ok = !std::ferror(file);
+    std::fclose(file);
+    out = hasher.digest();
+    return ok;
+}
+
+// Content hashes keyed by (path, size, mtime), kept outside the project so the cache itself never
+// becomes part of the build context. Entries modified within two seconds of the last save are
+// rehashed: a write in the same timestamp tick as the save would otherwise go unnoticed.
+class ScanCache {
+public:
+    explicit ScanCache(const std::string &folderPath)
+        : cachePath(operatorCacheDir() / (FastHasher::of(fs::absolute(folderPath).lexically_normal().string()).hex() + ".scan")) {
+        std::ifstream in(cachePath);
+        std::string magic;
+        long long savedAt = 0;
+        if (!(in >> magic >> savedAt) || magic != "operator-scan-cache-v1")
+            return;
+        in.ignore();
+        long long racyAfter = savedAt - 2000000000LL;
+        std::string line;
+        while (std::getline(in, line)) {
+            Entry entry;
+            char high[17] = {}, low[17] = {};
+            unsigned long long size = 0;
+            int consumed = 0;
+            if (std::sscanf(line.c_str(), "%16s %16s %llu %lld %n", high, low, &size, &entry.mtime, &consumed) < 4 ||
+                consumed <= 0)
+                continue;
+            if (entry.mtime >= racyAfter)
+                continue;
+            entry.size = size;
+            entry.hash.high = std::strtoull(high, nullptr, 16);
+            entry.hash.low = std::strtoull(low, nullptr, 16);
+            entries.emplace(line.substr(static_cast<size_t>(consumed)), entry);
+        }
+    }
+    
+    bool lookup(const std::string &path, uintmax_t size, long long mtime, Hash128 &hash) const {
+        auto it = entries.find(path);
+        if (it == entries.end() || it->second.size != size || it->second.mtime != mtime)
+            return false;
+        hash = it->second.hash;
+        return true;
+    }
+    
+    void store(const std::string &path, uintmax_t size, long long mtime, const Hash128 &hash) {
+        updated[path] = Entry{size, mtime, hash};
+    }
+    
+    void save() const {
+        std::error_code ec;
+        fs::create_directories(cachePath.parent_path(), ec);
+        fs::path temp = cachePath;
+        temp += ".tmp";
+        std::ofstream out(temp);
+        if (!out)
+            return;
+        out << "operator-scan-cache-v1 " << fileTimeNanos(fs::file_time_type::clock::now()) << "\n";
+        for (const auto &item : updated) {
+            char high[17], low[17];
+            std::snprintf(high, sizeof(high), "%016llx", static_cast<unsigned long long>(item.second.hash.high));
+            std::snprintf(low, sizeof(low), "%016llx", static_cast<unsigned long long>(item.second.hash.low));
+            out << high << " " << low << " " << item.second.size << " " << item.second.mtime << " " << item.first << "\n";
+        }
+        out.close();
+        fs::rename(temp, cachePath, ec);
+    }
+    
+private:
+    struct Entry {
+        uintmax_t size = 0;
+        long long mtime = 0;
+        Hash128 hash;
+    };
+    fs::path cachePath;
+    std::map<std::string, Entry> entries;
+    std::map<std::string, Entry> updated;
+};
+
+std::vector<std::string> dockerfileBaseImages(const std::string &dockerfile) {
+    std::vector<std::string> images;
+    std::set<std::string> stages;
+    std::istringstream in(dockerfile);
+    std::string line;
+    static const std::regex fromRegex("^\\s*FROM\\s+(.*)$", std::regex::icase);
+    while (std::getline(in, line)) {
+        std::smatch match;
+        if (!std::regex_match(line, match, fromRegex))
+            continue;
+        std::istringstream words(match[1].str());
+        std::string word, image, alias;
+        while (words >> word && word.rfind("--", 0) == 0) {}
+        image = word;
+        if (words >> word && lowercase(word) == "as")
+            words >> alias;
+        if (!image.empty() && image != "scratch" && !stages.count(image))
+            images.push_back(image);
+        if (!alias.empty())
+            stages.insert(alias);
+    }
+    return images;
+}
+
+// Local lookup only: a digest the daemon already knows. Unpulled or floating tags hash as their name.
+std::string resolveImageDigest(const std::string &image) {
+    if (image.find("@sha256:") != std::string::npos)
+        return image;
+    std::string command = "docker image inspect --format '{{index .RepoDigests 0}}' " + shellQuote(image) + " 2>/dev/null";
+    FILE *pipe = popen(command.c_str(), "r");
+    if (!pipe)
+        return image;
+    char buffer[512];
+    std::string digest;
+    while (std::fgets(buffer, sizeof(buffer), pipe))
+        digest += buffer;
+    int status = pclose(pipe);
+    while (!digest.empty() && std::isspace(static_cast<unsigned char>(digest.back())))
+        digest.pop_back();
+    return status == 0 && digest.find("@sha256:") != std::string::npos ? digest : image;
+}
+
+// Stable across machines and checkouts: only the rendered Dockerfile, base image identities and the
+// path, type, mode and content of every file the build would read feed the hash.
+bool computeFingerprint(const std::string &folderPath, Hash128 &fingerprint) {
+    std::ostream quiet(nullptr);
+    std::string dockerfile = renderDockerfile(folderPath, quiet);
+    if (dockerfile.empty()) {
+        std::ifstream existing(fs::path(folderPath) / "Dockerfile");
+        dockerfile.assign((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+    }
+    if (dockerfile.empty()) {
+        std::cerr << "지원하는 언어가 감지되지 않았고 Dockerfile도 없습니다.\n";
+        return false;
+    }
+    
+    std::string dockerfileName;
+    std::string contextDir = buildContextDir(folderPath, dockerfile, dockerfileName);
+    auto entries = collectContextEntries(contextDir, dockerfile, dockerfileName);
+    std::vector<Hash128> hashes(entries.size());
+    std::vector<std::pair<uintmax_t, long long>> stats(entries.size());
+    std::vector<size_t> pending;
+    ScanCache cache(contextDir);
+    fs::path root(contextDir);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].type != fs::file_type::regular)
+            continue;
+        std::error_code ec;
+        fs::path path = root / entries[i].path;
+        stats[i] = {fs::file_size(path, ec), fileTimeNanos(fs::last_write_time(path, ec))};
+        if (cache.lookup(entries[i].path, stats[i].first, stats[i].second, hashes[i])) {
+            operatorMetrics.fileHashHits.add();
+        } else {
+            operatorMetrics.fileHashMisses.add();
+            pending.push_back(i);
+        }
+    }
+    
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    unsigned threadCount = std::min<size_t>(effectiveThreads(), std::max<size_t>(pending.size(), 1));
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&] {
+            for (size_t k; (k = next.fetch_add(1)) < pending.size();) {
+                size_t i = pending[k];
+                if (!hashFile(root / entries[i].path, hashes[i]))
+                    failed = true;
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    if (failed) {
+        std::cerr << "일부 파일을 읽지 못했습니다.\n";
+        return false;
+    }
+    
+    FastHasher hasher;
+    auto feed = [&](const std::string &text) { hasher.update(text.data(), text.size()); };
+    feed("dockerfile " + FastHasher::of(dockerfile).hex() + "\n");
+    for (const auto &image : dockerfileBaseImages(dockerfile))
+        feed("base " + resolveImageDigest(image) + "\n");
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto &entry = entries[i];
+        if (entry.type == fs::file_type::directory) {
+            feed("dir " + entry.path + "\n");
+        } else if (entry.type == fs::file_type::symlink) {
+            std::error_code ec;
+            feed("link " + entry.path + " " + fs::read_symlink(root / entry.path, ec).generic_string() + "\n");
+        } else {
+            feed(std::string(entry.executable ? "exec " : "file ") + entry.path + " " + hashes[i].hex() + "\n");
+            cache.store(entry.path, stats[i].first, stats[i].second, hashes[i]);
+        }
+    }
+    cache.save();
+    fingerprint = hasher.digest();
+    std::cerr << "fingerprint: 항목 " << entries.size() << "개, 다시 읽은 파일 " << pending.size() << "개\n";
+    return true;
+}
+
+struct OptimizeFinding {
+    int line;
+    std::string message;
+    bool fixed;
+};
+
+bool isManifestInstall(const std::string &command) {
+    static const std::regex install("^(pip3? (install|wheel|download)( -\\S+)* (-r|--requirement)[ =]?\\S+( -\\S+)*|"
+                                    "pip3? install (-U|--upgrade) (pip|setuptools|wheel)( (pip|setuptools|wheel))*|"
+                                    "(npm (ci|install|i)|yarn( install)?|pnpm (install|i))( -\\S+)*|"
+                                    "go mod download( -\\S+)*|bundle install( -\\S+)*|composer install( -\\S+)*)$");
+    return std::regex_match(command, install);
+}
+
+// The context files a hand-written install RUN reads, or nothing when any of its commands needs more
+// of the source tree than the manifests.
+std::vector<std::string> inferInstallInputs(const std::string &contextDir, const DockerInstruction &instruction) {
+    static const std::regex requirementsRegex("(-r|--requirement)[ =]?(\\S+)");
+    std::vector<std::string> inputs;
+    for (const auto &command : instruction.commands) {
+        if (!isManifestInstall(command))
+            return {};
+        std::smatch match;
+        std::vector<std::string> found;
+        if (std::regex_search(command, match, requirementsRegex))
+            found = pythonInstallInputs(contextDir, false, match[2]);
+        else if (command.rfind("pip", 0) == 0)
+            continue;
+        else if (command.rfind("go ", 0) == 0)
+            found = goModInputs(contextDir);
+        else if (command.rfind("bundle", 0) == 0)
+            found = gemfileInputs(contextDir);
+        else if (command.rfind("composer", 0) == 0)
+            found = composerInputs(contextDir);
+        else
+            found = nodeInstallInputs(contextDir, "");
+        if (found.empty())
+            return {};
+        inputs.insert(inputs.end(), found.begin(), found.end());
+    }
+    return inputs;
+}
+
+int installSeconds(const std::string &command) {
+    static const std::pair<const char *, int> costs[] = {
+        {"pip", 40}, {"npm", 60}, {"yarn", 60}, {"pnpm", 45}, {"go mod", 25}, {"bundle", 45}, {"composer", 30}};
+    if (command.find("apt-get install") != std::string::npos)
+        return 20;
+    if (!isManifestInstall(command))
+        return 0;
+    for (const auto &cost : costs)
+        if (command.find(cost.first) != std::string::npos)
+            return cost.second;
+    return 0;
+}
+
+struct ToolchainImage {
+    const char *repository;
+    int sizeMb;
+    const char *runtime;
+    int runtimeMb;
+};
+
+// Approximate compressed sizes, only used to rank suggestions.
+const ToolchainImage toolchainImages[] = {
+    {"golang", 800, "gcr.io/distroless/static", 2},
+    {"rust", 1400, "debian:bookworm-slim", 75},
+    {"gcc", 1300, "debian:bookworm-slim", 75},
+    {"maven", 550, "eclipse-temurin:17-jre", 270},
+    {"gradle", 700, "eclipse-temurin:17-jre", 270},
+    {"openjdk", 470, "eclipse-temurin:17-jre", 270},
+    {"mcr.microsoft.com/dotnet/sdk", 750, "mcr.microsoft.com/dotnet/runtime", 190},
+    {"node", 950, "node:<tag>-slim", 240},
+    {"python", 1000, "python:<tag>-slim", 150},
+    {"ruby", 900, "ruby:<tag>-slim", 200},
+};
+
+const ToolchainImage *findToolchainImage(const std::string &image) {
+    std::string tag = imageTag(image);
+    for (const char *runtimeVariant : {"slim", "alpine", "jre", "distroless", "runtime"})
+        if (tag.find(runtimeVariant) != std::string::npos)
+            return nullptr;
+    std::string repo = imageRepository(image);
+    for (const auto &toolchain : toolchainImages)
+        if (repo == toolchain.repository)
+            return &toolchain;
+    return nullptr;
+}
+
+uintmax_t directorySize(const fs::path &dir) {
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec))
+        if (it->is_regular_file(ec))
+            total += it->file_size(ec);
+    return total;
+}
+
+std::string lineLabel(int line) {
+    return line > 0 ? std::to_string(line) + "행: " : "";
+}
+
+// Rewrites an existing Dockerfile with the same passes used for generated ones and reports what was
+// found. Only changes that cannot alter the build result are applied; the rest are suggestions.
+bool optimizeExistingDockerfile(const std::string &path) {
+    fs::path dockerfilePath = fs::is_directory(path) ? fs::path(path) / "Dockerfile" : fs::path(path);
+    std::ifstream in(dockerfilePath);
+    if (!in) {
+        std::cerr << "Dockerfile을 열 수 없습니다: " << dockerfilePath << "\n";
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string contextDir = dockerfilePath.parent_path().empty() ? "." : dockerfilePath.parent_path().string();
+    DockerfileIR docker = parseDockerfile(text);
+    if (docker.stages.empty()) {
+        std::cerr << "FROM 명령이 없습니다: " << dockerfilePath << "\n";
+        return false;
+    }
+    
+    std::vector<OptimizeFinding> findings;
+    int secondsSaved = 0, cacheMissSeconds = 0, megabytesSaved = 0, megabytesPossible = 0;
+    std::set<std::string> stageNames;
+    std::set<int> mountedLines, lateInstalls;
+    
+    for (auto &stage : docker.stages) {
+        std::string workdir = "/", copiedTo;
+        for (auto &instruction : stage.instructions) {
+            if (instruction.op == DockerOp::Workdir) {
+                if (!instruction.args.empty())
+                    workdir = instruction.args.front() == '/' ? instruction.args : workdir + "/" + instruction.args;
+                while (workdir.size() > 1 && workdir.back() == '/')
+                    workdir.pop_back();
+            } else if (isWholeContextCopy(instruction)) {
+                copiedTo = splitWords(instruction.args)[1];
+                if (copiedTo == "." || copiedTo == "./")
+                    copiedTo = workdir;
+                while (copiedTo.size() > 1 && copiedTo.back() == '/')
+                    copiedTo.pop_back();
+            } else if (instruction.op == DockerOp::Run) {
+                for (const auto &flag : instruction.flags)
+                    if (flag.rfind("--mount=", 0) == 0)
+                        mountedLines.insert(instruction.line);
+                bool aptInstall = false, aptClean = false;
+                for (const auto &command : instruction.commands) {
+                    aptInstall = aptInstall || command.find("apt-get install") != std::string::npos;
+                    aptClean = aptClean || command.find("/var/lib/apt/lists") != std::string::npos;
+                }
+                if (aptInstall && !aptClean) {
+                    findings.push_back({instruction.line, "apt 목록이 같은 레이어에서 정리되지 않습니다 (약 40MB)", true});
+                    megabytesSaved += 40;
+                }
+                if (!copiedTo.empty() && copiedTo == workdir) {
+                    instruction.inputs = inferInstallInputs(contextDir, instruction);
+                    if (!instruction.inputs.empty())
+                        lateInstalls.insert(instruction.line);
+                }
+            }
+        }
+    }
+    
+    for (auto &stage : docker.stages) {
+        if (!stage.name.empty())
+            stageNames.insert(stage.name);
+        if (stageNames.count(stage.image) && stage.name != stage.image)
+            continue;
+        if (stage.image == "scratch" || stage.image.find('$') != std::string::npos ||
+            stage.image.find("@sha256:") != std::string::npos)
+            continue;
+        std::string tag = imageTag(stage.image);
+        if (!tag.empty() && tag != "latest" && tag.find('.') != std::string::npos)
+            continue;
+        std::string digest = resolveImageDigest(stage.image);
+        bool pinned = digest.find("@sha256:") != std::string::npos;
+        if (pinned)
+            stage.image += digest.substr(digest.find('@'));
+        findings.push_back({stage.line, "고정되지 않은 베이스 이미지 태그: " + (tag.empty() ? stage.image + " (태그 없음)" : tag) +
+                            (pinned ? "" : " — 로컬에 digest가 없어 버전이 정해진 태그로 직접 고정하세요"), pinned});
+    }
+    
+    const DockerStage &runtime = docker.stages.back();
+    if (const ToolchainImage *toolchain = findToolchainImage(runtime.image)) {
+        std::string suggestion = toolchain->runtime;
+        size_t tagPos = suggestion.find("<tag>");
+        if (tagPos != std::string::npos) {
+            std::string tag = imageTag(runtime.image);
+            suggestion.replace(tagPos, 5, tag.empty() ? "lts" : tag);
+        }
+        int saving = toolchain->sizeMb - toolchain->runtimeMb;
+        megabytesPossible += saving;
+        findings.push_back({runtime.line, "최종 스테이지가 빌드 도구가 포함된 이미지(" + runtime.image + ")를 사용합니다 — 빌더 스테이지로 분리하고 " +
+                            suggestion + "에서 실행하면 약 " + std::to_string(saving) + "MB 감소", false});
+    }
+    static const std::regex buildTools("apt-get install[^&;|]*\\s(build-essential|gcc|g\\+\\+|make|cmake|clang|[a-z0-9.+-]+-dev)(\\s|$)");
+    for (const auto &instruction : runtime.instructions)
+        for (const auto &command : instruction.commands)
+            if (std::regex_search(command, buildTools))
+                findings.push_back({instruction.line, "최종 스테이지에 컴파일러/-dev 패키지를 설치합니다 — 빌더 스테이지로 옮기세요", false});
+    
+    // orderByVolatility and dedupeEnv move and merge instructions of a hand-written file; each one is listed.
+    auto isMeta = [](const DockerInstruction &instruction) {
+        return instruction.op == DockerOp::Label || instruction.op == DockerOp::Expose;
+    };
+    std::set<int> metaBelowOthers;
+    std::map<int, std::string> envArgs;
+    for (const auto &stage : docker.stages) {
+        bool other = false;
+        for (const auto &instruction : stage.instructions) {
+            if (isMeta(instruction) && other)
+                metaBelowOthers.insert(instruction.line);
+            other = other || !isMeta(instruction);
+            if (instruction.op == DockerOp::Env)
+                envArgs[instruction.line] = instruction.args;
+        }
+    }
+    
+    optimizeDockerfile(docker);
+    
+    for (const auto &stage : docker.stages) {
+        bool other = false;
+        for (const auto &instruction : stage.instructions) {
+            if (isMeta(instruction) && !other && metaBelowOthers.count(instruction.line))
+                findings.push_back({instruction.line, instruction.keyword + " 명령을 FROM 바로 뒤로 옮겼습니다 (RUN 캐시에 영향 없음)", true});
+            other = other || !isMeta(instruction);
+            auto env = envArgs.find(instruction.line);
+            if (instruction.op == DockerOp::Env && env != envArgs.end()) {
+                if (env->second != instruction.args)
+                    findings.push_back({instruction.line, "ENV를 합쳤습니다: " + instruction.args, true});
+                envArgs.erase(env);
+            }
+        }
+    }
+    for (const auto &env : envArgs)
+        findings.push_back({env.first, "ENV를 앞의 ENV에 합치거나 중복 할당이라 제거했습니다: " + env.second, true});
+    
+    std::set<int> stillLate;
+    for (const auto &stage : docker.stages) {
+        bool afterCopy = false;
+        for (const auto &instruction : stage.instructions) {
+            afterCopy = afterCopy || isWholeContextCopy(instruction);
+            if (instruction.op != DockerOp::Run)
+                continue;
+            if (afterCopy && !instruction.inputs.empty())
+                stillLate.insert(instruction.line);
+            bool mounted = false;
+            for (const auto &flag : instruction.flags)
+                mounted = mounted || flag.rfind("--mount=type=cache", 0) == 0;
+            if (mounted && !mountedLines.count(instruction.line)) {
+                int seconds = 0;
+                for (const auto &command : instruction.commands)
+                    seconds += installSeconds(command);
+                cacheMissSeconds += seconds / 2;
+                findings.push_back({instruction.line, "패키지 관리자 캐시 마운트를 추가했습니다", true});
+            }
+            if (lateInstalls.count(instruction.line) && !stillLate.count(instruction.line)) {
+                int seconds = 0;
+                for (const auto &command : instruction.commands)
+                    seconds += installSeconds(command);
+                secondsSaved += seconds;
+                findings.push_back({instruction.line, "의존성 설치가 전체 소스 COPY 뒤에 있어 소스 변경마다 다시 실행됩니다 — 매니페스트만 먼저 복사하도록 옮겼습니다", true});
+            }
+        }
+    }
+    for (int line : stillLate)
+        findings.push_back({line, "의존성 설치가 전체 소스 COPY 뒤에 있어 소스 변경마다 다시 실행됩니다 — 자동으로 옮기지 못했습니다", false});
     
-    std::vector<LanguageHandler*> candidates;
-    for (auto &handler : handlers) {
-        if (handler->detect(folderPath))
-            candidates.push_back(handler.get());
+    if (!fs::exists(fs::path(contextDir) / ".dockerignore")) {
+        uintmax_t heavy = 0;
+        std::string names;
+        for (const char *name : {".git", "node_modules", "__pycache__", ".venv", "venv", "target", "dist", "build", ".tox"}) {
+            fs::path dir = fs::path(contextDir) / name;
+            if (fs::is_directory(dir)) {
+                heavy += directorySize(dir);
+                names += std::string(names.empty() ? "" : ", ") + name;
+            }
+        }
+        findings.push_back({0, ".dockerignore가 없습니다" + (names.empty() ? std::string() :
+                            " — " + names + " 제외 시 빌드 컨텍스트 약 " + std::to_string(heavy / (1024 * 1024)) + "MB 감소"), false});
+    }
+    
+    std::sort(findings.begin(), findings.end(), [](const OptimizeFinding &a, const OptimizeFinding &b) { return a.line < b.line; });
+    std::cerr << "=== " << dockerfilePath.string() << " 분석 결과 ===\n";
+    for (const auto &finding : findings)
+        std::cerr << (finding.fixed ? "  [수정] " : "  [제안] ") << lineLabel(finding.line) << finding.message << "\n";
+    if (findings.empty())
+        std::cerr << "  개선할 항목을 찾지 못했습니다.\n";
+    std::cerr << "예상 효과 (추정): 소스 변경 시 재빌드 약 " << secondsSaved << "초 단축, 캐시 미스 시 다운로드 약 "
+              << cacheMissSeconds << "초 단축, 이미지 약 " << megabytesSaved << "MB 감소";
+    if (megabytesPossible > 0)
+        std::cerr << " (제안 적용 시 추가로 약 " << megabytesPossible << "MB)";
+    std::cerr << "\n";
+    
+    std::string rewritten = docker.render();
+    if (operatorOptions.output == "-") {
+        std::cout << rewritten;
+        return true;
+    }
+    std::ofstream out(operatorOptions.output);
+    if (!out) {
+        std::cerr << "출력 파일을 열 수 없습니다: " << operatorOptions.output << "\n";
+        return false;
+    }
+    out << rewritten;
+    std::cerr << "최적화된 Dockerfile: " << operatorOptions.output << "\n";
+    return true;
+}
+
+struct ImageSize {
+    const char *image;
+    int sizeMb;
+};
+
+// Uncompressed sizes as reported by `docker images`, by repository and variant suffix.
+const ImageSize baseImageSizes[] = {
+    {"python", 1000}, {"python:slim", 130}, {"python:alpine", 55},
+    {"node", 1000}, {"node:slim", 240}, {"node:alpine", 170},
+    {"golang", 800}, {"golang:alpine", 250},
+    {"rust", 1400}, {"rust:slim", 800}, {"rust:alpine", 850},
+    {"gcc", 1300},
+    {"openjdk", 650}, {"openjdk:slim", 420}, {"eclipse-temurin:jre", 270}, {"eclipse-temurin", 450},
+    {"ruby", 900}, {"ruby:slim", 200}, {"ruby:alpine", 90},
+    {"php", 480}, {"php:alpine", 80},
+    {"mcr.microsoft.com/dotnet/sdk", 700}, {"mcr.microsoft.com/dotnet/runtime", 190},
+    {"mcr.microsoft.com/dotnet/aspnet", 210}, {"mcr.microsoft.com/dotnet/runtime:alpine", 85},
+    {"mcr.microsoft.com/dotnet/aspnet:alpine", 105},
+    {"debian", 120}, {"debian:slim", 75}, {"ubuntu", 78}, {"alpine", 7},
+    {"gcr.io/distroless/static", 2}, {"gcr.io/distroless/base", 20}, {"gcr.io/distroless/cc", 25},
+    {"gcr.io/distroless/python3", 55}, {"gcr.io/distroless/nodejs18", 170}, {"gcr.io/distroless/java17", 230},
+    {"tonistiigi/xx", 1}, {"scratch", 0},
+};
+
+// Installed sizes of packages that dominate images; anything else counts as the per-ecosystem default.
+const ImageSize packageSizes[] = {
+    {"apt:build-essential", 250}, {"apt:gcc", 90}, {"apt:g++", 110}, {"apt:clang", 400}, {"apt:lld", 30},
+    {"apt:make", 1}, {"apt:python3", 30}, {"apt:libpq-dev", 10}, {"apt:libpq5", 1},
+    {"apt:libxml2-dev", 12}, {"apt:libxslt1-dev", 5}, {"apt:default-libmysqlclient-dev", 15},
+    {"apt:libcairo2-dev", 60}, {"apt:libpango1.0-dev", 40}, {"apt:librsvg2-dev", 30},
+    {"apt:libc6-dev", 20}, {"apt:libstdc++-12-dev", 20},
+    {"pip:numpy", 60}, {"pip:pandas", 70}, {"pip:scipy", 110}, {"pip:torch", 1800}, {"pip:tensorflow", 1200},
+    {"pip:opencv-python", 90}, {"pip:matplotlib", 40}, {"pip:scikit-learn", 40}, {"pip:django", 30},
+    {"pip:lxml", 15}, {"pip:pillow", 12}, {"pip:grpcio", 20}, {"pip:pyarrow", 120}, {"pip:boto3", 80},
+    {"npm:puppeteer", 300}, {"npm:typescript", 50}, {"npm:next", 120}, {"npm:sharp", 35}, {"npm:canvas", 30},
+    {"npm:aws-sdk", 90}, {"npm:webpack", 30}, {"npm:@angular/core", 30}, {"npm:electron", 200},
+};
+
+int lookupSize(const std::string &key, int fallback) {
+    for (const auto &entry : packageSizes)
+        if (key == entry.image)
+            return entry.sizeMb;
+    return fallback;
+}
+
+std::string imageVariantOf(const std::string &image) {
+    std::string tag = imageTag(image);
+    for (const char *variant : {"slim", "alpine", "jre"})
+        if (tag.find(variant) != std::string::npos)
+            return variant;
+    return "";
+}
+
+int baseImageSize(const std::string &image, bool &known) {
+    std::string repo = imageRepository(image);
+    std::string variant = imageVariantOf(image);
+    known = true;
+    for (const std::string &key : {repo + (variant.empty() ? "" : ":" + variant), repo})
+        for (const auto &entry : baseImageSizes)
+            if (key == entry.image || (key.rfind(entry.image, 0) == 0 && key.size() > std::strlen(entry.image) &&
+                                       key[std::strlen(entry.image)] == '-'))
+                return entry.sizeMb;
+    known = false;
+    return 150;
+}
+
+// Candidate runtime images for the same language and version.
+std::string runtimeVariant(const std::string &image, const std::string &variant) {
+    std::string repo = imageRepository(image);
+    std::string tag = imageTag(image);
+    std::string version = tag.substr(0, tag.find('-'));
+    if (version == "latest" || version == "slim" || version == "alpine")
+        version.clear();
+    auto tagged = [&](const std::string &suffix) {
+        return repo + ":" + (version.empty() ? suffix : version + "-" + suffix);
+    };
+    if (variant == "slim") {
+        if (repo == "python" || repo == "node" || repo == "ruby" || repo == "rust")
+            return tagged("slim");
+        if (repo == "openjdk")
+            return tagged("jdk-slim");
+        if (repo == "gcc" || repo == "golang" || repo == "debian")
+            return "debian:bookworm-slim";
+        if (repo == "mcr.microsoft.com/dotnet/sdk")
+            return "mcr.microsoft.com/dotnet/runtime:" + (version.empty() ? "8.0" : version);
+        return "";
+    }
+    if (variant == "alpine") {
+        if (repo == "python" || repo == "node" || repo == "ruby" || repo == "golang" || repo == "rust")
+            return tagged("alpine");
+        if (repo == "php")
+            return repo + ":" + (version.empty() ? "" : version + "-") + "fpm-alpine";
+        if (repo == "gcc" || repo == "debian")
+            return "alpine:3.19";
+        if (repo.rfind("mcr.microsoft.com/dotnet/", 0) == 0)
+            return "mcr.microsoft.com/dotnet/runtime:" + (version.empty() ? "8.0" : version) + "-alpine";
+        return "";
+    }
+    if (variant == "distroless") {
+        if (repo == "python")
+            return "gcr.io/distroless/python3-debian12";
+        if (repo == "node")
+            return "gcr.io/distroless/nodejs18-debian12";
+        if (repo == "golang")
+            return "gcr.io/distroless/static-debian12";
+        if (repo == "rust" || repo == "gcc" || repo == "debian")
+            return "gcr.io/distroless/cc-debian12";
+        if (repo == "openjdk" || repo == "eclipse-temurin")
+            return "gcr.io/distroless/java17-debian12";
+        return "";
+    }
+    return image;
+}
+
+struct StepEstimate {
+    double seconds = 0;
+    double sizeMb = 0;
+    bool systemPackages = false;
+};
+
+struct ProjectFacts {
+    std::string folder;
+    double contextMb = 0;
+    size_t sourceFiles = 0;
+};
+
+std::vector<std::string> manifestPackages(const std::string &folder, const std::string &command) {
+    std::vector<std::string> names;
+    auto words = splitWords(command);
+    bool fromManifest = true;
+    for (size_t i = 1; i < words.size(); ++i) {
+        const std::string &word = words[i];
+        if (word == "install" || word == "add" || word == "require" || word == "wheel" || word == "ci" || word == "i")
+            continue;
+        if (word[0] == '-' || word.find('/') != std::string::npos || word.find('=') != std::string::npos ||
+            words[i - 1] == "-r" || words[i - 1].rfind("--", 0) == 0)
+            continue;
+        fromManifest = false;
+        names.push_back(word);
+    }
+    if (!fromManifest)
+        return names;
+    if (command.find("pip") != std::string::npos) {
+        for (const auto &name : readRequirementNames(folder))
+            names.push_back(name);
+    } else if (command.find("npm") != std::string::npos || command.find("yarn") != std::string::npos ||
+               command.find("pnpm") != std::string::npos) {
+        for (const auto &name : readPackageJsonDependencies(folder))
+            names.push_back(name);
+    }
+    return names;
+}
+
+size_t countMatches(const std::string &folder, const std::string &file, const std::regex &pattern) {
+    std::ifstream in(fs::path(folder) / file);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return static_cast<size_t>(std::distance(std::sregex_iterator(content.begin(), content.end(), pattern), std::sregex_iterator()));
+}
+
+// Per-command heuristics: download/install time scales with package count and size, compile time
+// with the number of sources or crates. Good enough to rank variants, not to promise numbers.
+StepEstimate estimateCommand(const ProjectFacts &facts, const std::string &command) {
+    StepEstimate step;
+    static const std::regex aptRegex("apt-get install|apk add");
+    if (std::regex_search(command, aptRegex)) {
+        step.systemPackages = true;
+        step.seconds += 8;
+        for (const auto &word : splitWords(command)) {
+            if (word[0] == '-' || word == "apt-get" || word == "xx-apt-get" || word == "install" || word == "apk" || word == "add")
+                continue;
+            double size = lookupSize("apt:" + word, 6);
+            step.sizeMb += size;
+            step.seconds += 0.5 + size * 0.05;
+        }
+        return step;
+    }
+    std::string ecosystem = command.find("pip") != std::string::npos ? "pip" :
+                            std::regex_search(command, std::regex("\\b(npm|yarn|pnpm)\\b")) ? "npm" : "";
+    if (!ecosystem.empty() && std::regex_search(command, std::regex("\\b(install|ci|wheel|add)\\b"))) {
+        if (command.find("--upgrade pip") != std::string::npos) {
+            step.seconds += 4;
+            return step;
+        }
+        for (const auto &name : manifestPackages(facts.folder, command)) {
+            double size = lookupSize(ecosystem + ":" + lowercase(name), ecosystem == "pip" ? 4 : 2);
+            step.sizeMb += size;
+            step.seconds += 1.5 + size * 0.05;
+        }
+        step.seconds += 5;
+        return step;
+    }
+    if (std::regex_search(command, std::regex("\\bgo mod download"))) {
+        size_t modules = countMatches(facts.folder, "go.sum", std::regex("/go\\.mod ")) ;
+        step.seconds = 3 + modules * 0.5;
+        step.sizeMb = modules * 2.0;
+        return step;
+    }
+    if (std::regex_search(command, std::regex("\\bgo build"))) {
+        step.seconds = 15 + facts.sourceFiles * 0.2;
+        step.sizeMb = 15;
+        return step;
+    }
+    if (command.find("cargo build") != std::string::npos) {
+        size_t crates = countMatches(facts.folder, "Cargo.lock", std::regex("\\[\\[package\\]\\]"));
+        if (crates == 0)
+            crates = countMatches(facts.folder, "Cargo.toml", std::regex("\\n[A-Za-z0-9_-]+\\s*=")) * 8;
+        step.seconds = 20 + crates * 1.5;
+        step.sizeMb = 10;
+        return step;
+    }
+    if (std::regex_search(command, std::regex("(g\\+\\+|clang\\+\\+|gcc|cmake|make)\\b"))) {
+        step.seconds = 2 + facts.sourceFiles * 1.5;
+        step.sizeMb = 2;
+        return step;
+    }
+    if (command.find("jlink ") != std::string::npos) {
+        step.seconds = 15;
+        step.sizeMb = 50;
+        return step;
+    }
+    if (std::regex_search(command, std::regex("\\b(mvn|gradle)\\b"))) {
+        step.seconds = 90;
+        step.sizeMb = 150;
+        return step;
+    }
+    if (command.find("dotnet") != std::string::npos) {
+        step.seconds = 25;
+        step.sizeMb = 30;
+        return step;
+    }
+    if (std::regex_search(command, std::regex("\\b(bundle|gem|composer)\\b"))) {
+        size_t gems = countMatches(facts.folder, "Gemfile", std::regex("\\bgem\\s")) +
+                      countMatches(facts.folder, "composer.json", std::regex("\"[a-z0-9-]+/[a-z0-9-]+\"\\s*:"));
+        step.seconds = 10 + gems * 2.0;
+        step.sizeMb = gems * 3.0;
+        return step;
+    }
+    step.seconds = 1;
+    return step;
+}
+
+struct VariantEstimate {
+    std::string name;
+    std::string baseImage;
+    double sizeMb = 0;
+    double coldSeconds = 0;
+    double warmSeconds = 0;
+    bool compatible = true;
+    bool knownBase = true;
+    std::vector<std::string> notes;
+};
+
+// The final stage and the stages it is built FROM, final stage first; the last one starts from a real image.
+std::vector<size_t> runtimeChain(const DockerfileIR &docker) {
+    std::vector<size_t> chain = {docker.stages.size() - 1};
+    while (chain.size() <= docker.stages.size()) {
+        const std::string &image = docker.stages[chain.back()].image;
+        auto stage = std::find_if(docker.stages.begin(), docker.stages.begin() + chain.back(),
+                                  [&](const DockerStage &s) { return s.name == image; });
+        if (stage == docker.stages.begin() + chain.back())
+            break;
+        chain.push_back(stage - docker.stages.begin());
+    }
+    return chain;
+}
+
+// The image the final stage ends up on, following `FROM <stage>` back to a real image.
+std::string runtimeImage(const DockerfileIR &docker) {
+    return docker.stages[runtimeChain(docker).back()].image;
+}
+
+// Cold: nothing cached. Warm: base images and layers cached, one source file edited, so everything
+// from the first whole-context COPY of a stage onwards (and stages copying from it) runs again.
+VariantEstimate estimateVariant(const DockerfileIR &docker, const ProjectFacts &facts, const std::string &name,
+                                const std::string &runtimeImage) {
+    VariantEstimate estimate;
+    estimate.name = name;
+    estimate.baseImage = runtimeImage;
+    const double pullMbPerSecond = 40, contextMbPerSecond = 100, exportMbPerSecond = 150;
+    // Output: what `COPY --from` takes from a stage. Image: the whole filesystem a `FROM <stage>` starts with.
+    std::map<std::string, double> stageOutputMb, stageImageMb;
+    bool compiles = false, installsPackages = false;
+    std::set<std::string> dirtyStages;
+    estimate.coldSeconds = estimate.warmSeconds = facts.contextMb / contextMbPerSecond;
+    auto chain = runtimeChain(docker);
+    const DockerStage &runtimeBase = docker.stages[chain.back()];
+    size_t builderStages = 0;
+    
+    for (size_t s = 0; s < docker.stages.size(); ++s) {
+        const DockerStage &stage = docker.stages[s];
+        bool final = s + 1 == docker.stages.size();
+        bool runtime = std::find(chain.begin(), chain.end(), s) != chain.end();
+        // Test and dev stages are not part of the image build.
+        if (std::regex_match(stage.name, std::regex("(.*-)?(test|dev)")))
+            continue;
+        builderStages += !runtime;
+        std::string image = s == chain.back() ? runtimeImage : stage.image;
+        bool known = true;
+        double base = 0;
+        if (stageImageMb.count(image)) {
+            base = stageImageMb[image];
+        } else {
+            base = baseImageSize(image, known);
+            estimate.coldSeconds += base / pullMbPerSecond;
+        }
+        if (s == chain.back())
+            estimate.knownBase = known;
+        double stageMb = base, artifactMb = 0;
+        bool dirty = dirtyStages.count(image) > 0;
+        for (const auto &instruction : stage.instructions) {
+            StepEstimate step;
+            if (instruction.op == DockerOp::Run) {
+                for (const auto &command : instruction.commands) {
+                    StepEstimate part = estimateCommand(facts, command);
+                    step.seconds += part.seconds;
+                    step.sizeMb += part.sizeMb;
+                    if (!part.systemPackages)
+                        artifactMb += part.sizeMb;
+                    static const std::regex compileRegex("\\b(go build|cargo build|g\\+\\+|clang\\+\\+|mvn|gradle|dotnet (build|publish))\\b");
+                    if (runtime && std::regex_search(command, compileRegex))
+                        compiles = true;
+                    installsPackages = installsPackages || std::regex_search(command, std::regex("\\b(pip|npm|yarn|pnpm)\\b"));
+                }
+            } else if (isWholeContextCopy(instruction)) {
+                step.sizeMb = facts.contextMb;
+                artifactMb += step.sizeMb;
+                step.seconds = facts.contextMb / exportMbPerSecond;
+                dirty = true;
+            } else if (instruction.op == DockerOp::Copy) {
+                for (const auto &flag : instruction.flags) {
+                    if (flag.rfind("--from=", 0) != 0)
+                        continue;
+                    std::string from = flag.substr(7);
+                    step.sizeMb = stageOutputMb.count(from) ? stageOutputMb[from] : 0;
+                    artifactMb += step.sizeMb;
+                    dirty = dirty || dirtyStages.count(from);
+                }
+            }
+            stageMb += step.sizeMb;
+            estimate.coldSeconds += step.seconds;
+            if (dirty)
+                estimate.warmSeconds += step.seconds;
+        }
+        // Later stages copy build outputs, not the whole builder filesystem.
+        stageOutputMb[stage.name.empty() ? std::to_string(s) : stage.name] = artifactMb;
+        stageImageMb[stage.name.empty() ? std::to_string(s) : stage.name] = stageMb;
+        if (dirty)
+            dirtyStages.insert(stage.name.empty() ? std::to_string(s) : stage.name);
+        if (final)
+            estimate.sizeMb = stageMb;
     }
     
-    if (candidates.empty()) {
+    bool hasRun = false, usesApt = false;
+    for (size_t s : chain) {
+        for (const auto &instruction : docker.stages[s].instructions) {
+            hasRun = hasRun || instruction.op == DockerOp::Run;
+            for (const auto &command : instruction.commands)
+                usesApt = usesApt || command.find("apt-get") != std::string::npos;
+        }
+    }
+    if (name == "alpine") {
+        if (usesApt)
+            estimate.notes.push_back("apt-get 명령을 apk 패키지로 바꿔야 합니다");
+        if (builderStages > 0)
+            estimate.notes.push_back("빌더 스테이지의 glibc 바이너리/휠은 musl에서 실행되지 않습니다 — 빌더도 alpine으로 바꿔야 합니다");
+        estimate.compatible = !usesApt && builderStages == 0;
+        if (estimate.compatible && installsPackages)
+            estimate.notes.push_back("musl용 바이너리 휠이 없는 패키지는 소스에서 빌드됩니다");
+    }
+    if (compiles && imageRepository(runtimeImage) != imageRepository(runtimeBase.image)) {
+        estimate.notes.push_back("최종 스테이지에서 컴파일하므로 빌더 스테이지를 분리해야 합니다");
+        estimate.compatible = false;
+    }
+    if (name == "distroless") {
+        if (hasRun)
+            estimate.notes.push_back("셸이 없어 최종 스테이지의 RUN을 빌더 스테이지로 옮겨야 합니다");
+        estimate.compatible = !hasRun;
+    }
+    if (!estimate.knownBase)
+        estimate.notes.push_back("크기 표에 없는 베이스 이미지입니다 (150MB로 가정)");
+    return estimate;
+}
+
+bool estimateProject(const std::string &folderPath) {
+    std::ostream quiet(nullptr);
+    std::string dockerfile = renderDockerfile(folderPath, quiet);
+    if (dockerfile.empty()) {
         std::cerr << "지원하는 언어가 감지되지 않았습니다. (Unsupported project)\n";
-        return;
+        return false;
     }
+    DockerfileIR docker = parseDockerfile(dockerfile);
     
-    std::string dockerContent;
-    if (candidates.size() == 1) {
-        auto handler = candidates[0];
-        std::cout << "감지된 언어: " << handler->getName() << "\n";
-        auto dependencies = handler->extractDependencies(folderPath);
-        if (!dependencies.empty()) {
-            std::cout << "\n=== 감지된 라이브러리 (" << handler->getName() << ") ===\n";
-            for (const auto &dep : dependencies)
-                std::cout << "  - " << dep << "\n";
-            std::cout << "===========================\n\n";
+    ProjectFacts facts;
+    facts.folder = folderPath;
+    uintmax_t contextBytes = 0;
+    std::string dockerfileName;
+    std::string contextDir = buildContextDir(folderPath, dockerfile, dockerfileName);
+    for (const auto &entry : collectContextEntries(contextDir, dockerfile, dockerfileName)) {
+        if (entry.type != fs::file_type::regular)
+            continue;
+        std::error_code ec;
+        contextBytes += fs::file_size(fs::path(contextDir) / entry.path, ec);
+        std::string extension = fs::path(entry.path).extension().string();
+        for (const char *source : {".go", ".rs", ".cpp", ".cc", ".cxx", ".c", ".cs", ".java"})
+            facts.sourceFiles += extension == source;
+    }
+    facts.contextMb = contextBytes / (1024.0 * 1024.0);
+    
+    const std::string current = runtimeImage(docker);
+    std::vector<VariantEstimate> variants;
+    variants.push_back(estimateVariant(docker, facts, "current", current));
+    for (const char *variant : {"slim", "alpine", "distroless"}) {
+        std::string image = runtimeVariant(current, variant);
+        if (!image.empty() && image != current)
+            variants.push_back(estimateVariant(docker, facts, variant, image));
+    }
+    
+    const VariantEstimate *recommended = &variants.front();
+    for (const auto &variant : variants)
+        if (variant.compatible && variant.sizeMb < recommended->sizeMb)
+            recommended = &variant;
+    
+    std::string json = "{\n";
+    json += "  \"project\": " + jsonString(fs::absolute(folderPath).lexically_normal().string()) + ",\n";
+    json += "  \"stages\": " + std::to_string(docker.stages.size()) + ",\n";
+    json += "  \"context_mb\": " + jsonNumber(facts.contextMb) + ",\n";
+    json += "  \"variants\": [\n";
+    for (size_t i = 0; i < variants.size(); ++i) {
+        const auto &variant = variants[i];
+        json += "    {\"name\": " + jsonString(variant.name) + ", \"base_image\": " + jsonString(variant.baseImage) +
+                ", \"size_mb\": " + jsonNumber(variant.sizeMb) + ", \"cold_build_seconds\": " + jsonNumber(variant.coldSeconds) +
+                ", \"warm_build_seconds\": " + jsonNumber(variant.warmSeconds) +
+                ", \"compatible\": " + (variant.compatible ? "true" : "false") + ", \"notes\": " + jsonArray(variant.notes) + "}" +
+                (i + 1 < variants.size() ? ",\n" : "\n");
+    }
+    json += "  ],\n";
+    json += "  \"recommended\": " + jsonString(recommended->name) + "\n}\n";
+    
+    if (operatorOptions.output == "-") {
+        std::cout << json;
+        return true;
+    }
+    std::ofstream out(operatorOptions.output);
+    if (!out) {
+        std::cerr << "출력 파일을 열 수 없습니다: " << operatorOptions.output << "\n";
+        return false;
+    }
+    out << json;
+    return true;
+}
+
+// ---- fleet export ----
+// `operator export <folder>...` writes one row per project, language and dependency into a columnar file;
+// `operator query` scans it. Layout, little-endian:
+//   "OPCOL1\0\0", u32 rows, u32 columns, then per column:
+//   u16 name length, name, u8 kind ('s' dictionary-encoded string, 'f' float64), u64 payload size, payload
+//   's' payload: u32 dictionary size, per entry u32 length + bytes, then a u32 dictionary index per row
+//   'f' payload: one float64 per row
+// A reader skips the columns it does not need by their payload size.
+
+const char columnarMagic[8] = {'O', 'P', 'C', 'O', 'L', '1', 0, 0};
+
+struct ColumnarColumn {
+    std::string name;
+    char kind = 's';
+    std::vector<std::string> dictionary;
+    std::map<std::string, uint32_t> lookup;
+    std::vector<uint32_t> indexes;
+    std::vector<double> numbers;
+    
+    void push(const std::string &value) {
+        auto inserted = lookup.emplace(value, static_cast<uint32_t>(dictionary.size()));
+        if (inserted.second)
+            dictionary.push_back(value);
+        indexes.push_back(inserted.first->second);
+    }
+    
+    void push(double value) { numbers.push_back(value); }
+    
+    std::string text(size_t row) const {
+        if (kind == 's')
+            return dictionary[indexes[row]];
+        double value = numbers[row];
+        return value == static_cast<long long>(value) ? std::to_string(static_cast<long long>(value)) : jsonNumber(value);
+    }
+};
+
+void putLittleEndian(std::string &out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+bool getLittleEndian(std::istream &in, uint64_t &value, int bytes) {
+    unsigned char data[8];
+    if (!in.read(reinterpret_cast<char *>(data), bytes))
+        return false;
+    value = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        value = (value << 8) | data[i];
+    return true;
+}
+
+std::string encodeColumnar(const std::vector<ColumnarColumn> &columns, uint32_t rows) {
+    std::string out(columnarMagic, sizeof(columnarMagic));
+    putLittleEndian(out, rows, 4);
+    putLittleEndian(out, columns.size(), 4);
+    for (const auto &column : columns) {
+        std::string payload;
+        if (column.kind == 's') {
+            putLittleEndian(payload, column.dictionary.size(), 4);
+            for (const auto &entry : column.dictionary) {
+                putLittleEndian(payload, entry.size(), 4);
+                payload += entry;
+            }
+            for (uint32_t index : column.indexes)
+                putLittleEndian(payload, index, 4);
         } else {
-            std::cout << "\n자동 감지된 라이브러리가 없습니다 (" << handler->getName() << ").\n\n";
+            for (double number : column.numbers) {
+                uint64_t bits;
+                std::memcpy(&bits, &number, sizeof(bits));
+                putLittleEndian(payload, bits, 8);
+            }
         }
-        dockerContent = handler->generateDockerfile(folderPath, dependencies);
-    } else {
-        std::cout << "여러 언어가 감지되었습니다. 모든 언어에 대한 Dockerfile 내용을 생성합니다.\n";
-        dockerContent = "";
-        for (auto handler : candidates) {
-            auto dependencies = handler->extractDependencies(folderPath);
-            std::cout << "\n[" << handler->getName() << "] 감지된 라이브러리:\n";
-            if (!dependencies.empty()) {
-                for (const auto &dep : dependencies)
-                    std::cout << "  - " << dep << "\n";
-            } else {
-                std::cout << "  없음\n";
+        putLittleEndian(out, column.name.size(), 2);
+        out += column.name;
+        out += column.kind;
+        putLittleEndian(out, payload.size(), 8);
+        out += payload;
+    }
+    return out;
+}
+
+// Reads the named columns (all of them when `wanted` is empty) in file order.
+bool decodeColumnar(std::istream &in, const std::set<std::string> &wanted, std::vector<ColumnarColumn> &columns, uint32_t &rows) {
+    char magic[sizeof(columnarMagic)];
+    uint64_t rowCount, columnCount;
+    // Seeking past the end does not fail, so skipped columns are checked against the size.
+    in.seekg(0, std::ios::end);
+    std::streamoff fileSize = in.tellg();
+    in.seekg(0);
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, columnarMagic, sizeof(magic)) != 0 ||
+        !getLittleEndian(in, rowCount, 4) || !getLittleEndian(in, columnCount, 4))
+        return false;
+    rows = static_cast<uint32_t>(rowCount);
+    for (uint64_t c = 0; c < columnCount; ++c) {
+        uint64_t nameSize, payloadSize;
+        ColumnarColumn column;
+        if (!getLittleEndian(in, nameSize, 2))
+            return false;
+        column.name.resize(nameSize);
+        if (!in.read(&column.name[0], nameSize) || !in.get(column.kind) || !getLittleEndian(in, payloadSize, 8))
+            return false;
+        if (!wanted.empty() && !wanted.count(column.name)) {
+            if (payloadSize > static_cast<uint64_t>(fileSize - in.tellg()))
+                return false;
+            in.seekg(static_cast<std::streamoff>(payloadSize), std::ios::cur);
+            if (!in)
+                return false;
+            continue;
+        }
+        if (column.kind == 's') {
+            uint64_t entries, size, index;
+            if (!getLittleEndian(in, entries, 4))
+                return false;
+            for (uint64_t i = 0; i < entries; ++i) {
+                if (!getLittleEndian(in, size, 4))
+                    return false;
+                std::string entry(size, '\0');
+                if (size && !in.read(&entry[0], size))
+                    return false;
+                column.dictionary.push_back(entry);
+            }
+            for (uint32_t row = 0; row < rows; ++row) {
+                if (!getLittleEndian(in, index, 4) || index >= entries)
+                    return false;
+                column.indexes.push_back(static_cast<uint32_t>(index));
             }
-            dockerContent += "\n# ===== " + handler->getName() + " Stage =====\n";
-            dockerContent += handler->generateDockerfile(folderPath, dependencies);
-            dockerContent += "\n";
+        } else if (column.kind == 'f') {
+            uint64_t bits;
+            for (uint32_t row = 0; row < rows; ++row) {
+                if (!getLittleEndian(in, bits, 8))
+                    return false;
+                double number;
+                std::memcpy(&number, &bits, sizeof(number));
+                column.numbers.push_back(number);
+            }
+        } else {
+            return false;
+        }
+        columns.push_back(std::move(column));
+    }
+    return true;
+}
+
+bool exportFleet(const std::vector<std::string> &folders) {
+    using Clock = std::chrono::steady_clock;
+    auto elapsed = [](Clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+    };
+    std::vector<ColumnarColumn> columns;
+    auto addColumn = [&](const char *name, char kind) {
+        ColumnarColumn column;
+        column.name = name;
+        column.kind = kind;
+        columns.push_back(std::move(column));
+    };
+    for (const char *name : {"repo", "language", "dependency", "version", "source", "base_image"})
+        addColumn(name, 's');
+    for (const char *name : {"files", "scan_ms", "extract_ms", "generate_ms"})
+        addColumn(name, 'f');
+    
+    auto handlers = createHandlers();
+    uint32_t rows = 0;
+    size_t projects = 0;
+    for (const auto &folder : folders) {
+        if (!fs::is_directory(folder)) {
+            std::cerr << "프로젝트 폴더가 아닙니다 (건너뜀): " << folder << "\n";
+            continue;
+        }
+        ++projects;
+        std::string repo = fs::absolute(folder).lexically_normal().string();
+        auto started = Clock::now();
+        double files = static_cast<double>(projectIndex(folder).fileCount());
+        double scanMs = elapsed(started);
+        operatorMetrics.observePhase("scan", scanMs / 1000);
+        for (auto &handler : handlers) {
+            if (!handler->detect(folder))
+                continue;
+            started = Clock::now();
+            auto dependencies = handler->extractDependencies(folder);
+            double extractMs = elapsed(started);
+            operatorMetrics.observePhase("extract", extractMs / 1000);
+            started = Clock::now();
+            DockerfileIR own;
+            emitWithTemplates(own, *handler, folder, dependencies);
+            double generateMs = elapsed(started);
+            operatorMetrics.observePhase("generate", generateMs / 1000);
+            std::string baseImage = own.stages.empty() ? "" : runtimeImage(own);
+            
+            auto addRow = [&](const std::string &dependency, const std::string &version, const std::string &source) {
+                const std::string strings[] = {repo, handler->getName(), dependency, version, source, baseImage};
+                const double numbers[] = {files, scanMs, extractMs, generateMs};
+                for (size_t i = 0; i < 6; ++i)
+                    columns[i].push(strings[i]);
+                for (size_t i = 0; i < 4; ++i)
+                    columns[6 + i].push(numbers[i]);
+                ++rows;
+            };
+            if (dependencies.empty())
+                addRow("", "", "");
+            for (const auto &dep : dependencies)
+                addRow(dep, dependencyVersion(*handler, folder, dep), dependencySource(*handler, folder, dep));
         }
+        releaseProjectIndex(folder);
     }
     
-    fs::path dockerfilePath = fs::path(folderPath) / "Dockerfile";
-    std::ofstream outFile(dockerfilePath);
-    if (!outFile) {
-        std::cerr << "Dockerfile을 생성하지 못했습니다.\n";
+    std::string data = encodeColumnar(columns, rows);
+    if (operatorOptions.output == "-") {
+        std::cout.write(data.data(), data.size());
+    } else {
+        std::ofstream out(operatorOptions.output, std::ios::binary);
+        if (!out || !out.write(data.data(), data.size())) {
+            std::cerr << "출력 파일을 열 수 없습니다: " << operatorOptions.output << "\n";
+            return false;
+        }
+    }
+    std::cerr << projects << "개 프로젝트, " << rows << "행을 내보냈습니다.\n";
+    return true;
+}
+
+// `query <file>` prints every row as TSV; `query <file> <column> [<column>=<value>]` counts the values of one
+// column (for numbers: count, mean and max), optionally over the rows where another column has a given value.
+bool queryColumnar(const std::string &path, const std::string &column, const std::string &filter) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "파일을 열 수 없습니다: " << path << "\n";
+        return false;
+    }
+    std::string filterColumn = filter.substr(0, filter.find('='));
+    std::string filterValue = filter.find('=') == std::string::npos ? "" : filter.substr(filter.find('=') + 1);
+    std::set<std::string> wanted;
+    if (!column.empty())
+        wanted = {column, filterColumn};
+    wanted.erase("");
+    
+    std::vector<ColumnarColumn> columns;
+    uint32_t rows = 0;
+    if (!decodeColumnar(in, wanted, columns, rows)) {
+        std::cerr << "내보내기 파일 형식이 아닙니다: " << path << "\n";
+        return false;
+    }
+    auto find = [&](const std::string &name) -> const ColumnarColumn * {
+        for (const auto &c : columns)
+            if (c.name == name)
+                return &c;
+        return nullptr;
+    };
+    
+    if (column.empty()) {
+        for (size_t c = 0; c < columns.size(); ++c)
+            std::cout << (c ? "\t" : "") << columns[c].name;
+        std::cout << "\n";
+        for (uint32_t row = 0; row < rows; ++row) {
+            for (size_t c = 0; c < columns.size(); ++c)
+                std::cout << (c ? "\t" : "") << columns[c].text(row);
+            std::cout << "\n";
+        }
+        return true;
+    }
+    
+    const ColumnarColumn *target = find(column);
+    const ColumnarColumn *where = filter.empty() ? nullptr : find(filterColumn);
+    if (!target || (!filter.empty() && (!where || where->kind != 's'))) {
+        std::cerr << "없는 열입니다: " << (target ? filterColumn : column) << "\n";
+        return false;
+    }
+    // The filter is resolved to a dictionary index once, so the scan compares integers.
+    long long match = -1;
+    if (where) {
+        auto it = std::find(where->dictionary.begin(), where->dictionary.end(), filterValue);
+        if (it == where->dictionary.end())
+            return true;
+        match = it - where->dictionary.begin();
+    }
+    
+    if (target->kind == 'f') {
+        size_t count = 0;
+        double sum = 0, max = 0;
+        for (uint32_t row = 0; row < rows; ++row) {
+            if (where && where->indexes[row] != match)
+                continue;
+            double value = target->numbers[row];
+            sum += value;
+            max = count++ ? std::max(max, value) : value;
+        }
+        std::cout << "count\tmean\tmax\n" << count << "\t" << jsonNumber(count ? sum / count : 0) << "\t" << jsonNumber(max) << "\n";
+        return true;
+    }
+    std::vector<size_t> counts(target->dictionary.size());
+    for (uint32_t row = 0; row < rows; ++row)
+        if (!where || where->indexes[row] == match)
+            ++counts[target->indexes[row]];
+    std::vector<size_t> order;
+    for (size_t i = 0; i < counts.size(); ++i)
+        if (counts[i])
+            order.push_back(i);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return counts[a] != counts[b] ? counts[a] > counts[b] : target->dictionary[a] < target->dictionary[b];
+    });
+    for (size_t i : order)
+        std::cout << counts[i] << "\t" << target->dictionary[i] << "\n";
+    return true;
+}
+
+// ---- compile cache server ----
+// A minimal HTTP/WebDAV store for --compile-cache=<url>: ccache's http backend uses GET/HEAD/PUT/DELETE,
+// sccache's webdav backend additionally MKCOL and PROPFIND. Objects are plain files under the root.
+
+std::atomic<bool> cacheServerStopping{false};
+// Each connection may buffer one object of up to maxCacheObjectSize; further clients wait in the listen
+// backlog until a connection closes.
+const unsigned maxCacheConnections = 16;
+std::atomic<unsigned> cacheServerConnections{0};
+
+void stopCacheServer(int) {
+    cacheServerStopping = true;
+}
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::string version;
+    std::map<std::string, std::string> headers;
+    std::string body;
+    int rejected = 0;
+};
+
+// Larger objects are refused before any of the body is buffered.
+const uint64_t maxCacheObjectSize = 1ull << 30;
+
+// Reads one request from a keep-alive connection; bytes of a pipelined next request stay in buffer.
+bool readHttpRequest(int fd, std::string &buffer, HttpRequest &request) {
+    char chunk[65536];
+    std::string::size_type end;
+    while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (buffer.size() > 65536)
+            return false;
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+    std::istringstream head(buffer.substr(0, end));
+    buffer.erase(0, end + 4);
+    std::string line;
+    std::getline(head, line);
+    std::istringstream requestLine(line);
+    requestLine >> request.method >> request.path >> request.version;
+    request.headers.clear();
+    while (std::getline(head, line)) {
+        std::string::size_type colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        std::string key = line.substr(0, colon);
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        request.headers[key] = trim(line.substr(colon + 1));
+    }
+    request.rejected = 0;
+    size_t length = 0;
+    if (request.headers.count("content-length")) {
+        const std::string &value = request.headers["content-length"];
+        if (value.empty() || value.size() > 19 || value.find_first_not_of("0123456789") != std::string::npos) {
+            request.rejected = 400;
+            return true;
+        }
+        uint64_t parsed = std::strtoull(value.c_str(), nullptr, 10);
+        if (parsed > maxCacheObjectSize) {
+            request.rejected = 413;
+            return true;
+        }
+        length = static_cast<size_t>(parsed);
+    } else if (request.method == "PUT") {
+        // A chunked or unterminated body would be stored as an empty object that later hits as a valid result.
+        request.rejected = 411;
+        return true;
+    }
+    while (buffer.size() < length) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+    request.body = buffer.substr(0, length);
+    buffer.erase(0, length);
+    return !request.method.empty();
+}
+
+bool sendAll(int fd, const std::string &data) {
+    for (size_t sent = 0; sent < data.size();) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool sendHttpResponse(int fd, int status, const std::string &body, bool includeBody = true,
+                      const std::string &contentType = "application/octet-stream") {
+    static const std::map<int, std::string> reasons = {
+        {200, "OK"}, {201, "Created"}, {204, "No Content"}, {207, "Multi-Status"}, {400, "Bad Request"},
+        {404, "Not Found"}, {405, "Method Not Allowed"}, {411, "Length Required"}, {413, "Payload Too Large"},
+        {500, "Internal Server Error"}};
+    auto reason = reasons.find(status);
+    std::string head = "HTTP/1.1 " + std::to_string(status) + " " + (reason != reasons.end() ? reason->second : "") +
+                       "\r\nContent-Type: " + contentType + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    return sendAll(fd, includeBody ? head + body : head);
+}
+
+// Maps a request path to a file under root; rejects anything that could leave it.
+bool cacheObjectPath(const fs::path &root, const std::string &requestPath, fs::path &out) {
+    std::string decoded;
+    std::string path = requestPath.substr(0, requestPath.find('?'));
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (path[i] == '%' && i + 2 < path.size() && std::isxdigit(static_cast<unsigned char>(path[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(path[i + 2]))) {
+            decoded += static_cast<char>(std::stoi(path.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            decoded += path[i];
+        }
+    }
+    out = root;
+    std::istringstream segments(decoded);
+    std::string segment;
+    while (std::getline(segments, segment, '/')) {
+        if (segment == "..")
+            return false;
+        if (!segment.empty() && segment != ".")
+            out /= segment;
+    }
+    return true;
+}
+
+void serveCacheRequest(int fd, const fs::path &root, const HttpRequest &request) {
+    if (request.method == "GET" && request.path == "/metrics") {
+        sendHttpResponse(fd, 200, operatorMetrics.render(), true, "text/plain; version=0.0.4");
         return;
     }
-    outFile << dockerContent;
-    outFile.close();
+    operatorMetrics.countRequest(request.method);
+    fs::path file;
+    // Only PROPFIND may name the store itself; DELETE / would otherwise wipe it.
+    if (!cacheObjectPath(root, request.path, file) || (file == root && request.method != "PROPFIND")) {
+        sendHttpResponse(fd, 400, "");
+        return;
+    }
+    std::error_code ec;
+    const std::string &method = request.method;
+    if (method == "GET" || method == "HEAD") {
+        std::ifstream in(file, std::ios::binary);
+        if (!fs::is_regular_file(file, ec) || !in) {
+            if (method == "GET")
+                operatorMetrics.compileCacheMisses.add();
+            sendHttpResponse(fd, 404, "", method == "GET");
+            return;
+        }
+        if (method == "GET")
+            operatorMetrics.compileCacheHits.add();
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        sendHttpResponse(fd, 200, content, method == "GET");
+    } else if (method == "PUT") {
+        if (request.headers.count("transfer-encoding")) {
+            sendHttpResponse(fd, 411, "");
+            return;
+        }
+        // Written next to the target and renamed, so concurrent readers never see a partial object.
+        static std::atomic<unsigned long long> sequence{0};
+        fs::create_directories(file.parent_path(), ec);
+        fs::path temporary = file.parent_path() / ("." + file.filename().string() + ".tmp" + std::to_string(++sequence));
+        {
+            std::ofstream out(temporary, std::ios::binary);
+            out << request.body;
+            if (!out) {
+                fs::remove(temporary, ec);
+                sendHttpResponse(fd, 500, "");
+                return;
+            }
+        }
+        fs::rename(temporary, file, ec);
+        if (ec) {
+            fs::remove(temporary, ec);
+            sendHttpResponse(fd, 500, "");
+            return;
+        }
+        operatorMetrics.compileCacheStores.add();
+        operatorMetrics.compileCacheStoredBytes.add(request.body.size());
+        sendHttpResponse(fd, 201, "");
+    } else if (method == "DELETE") {
+        sendHttpResponse(fd, fs::remove_all(file, ec) > 0 ? 204 : 404, "");
+    } else if (method == "MKCOL") {
+        fs::create_directories(file, ec);
+        sendHttpResponse(fd, ec ? 500 : 201, "");
+    } else if (method == "PROPFIND") {
+        if (!fs::exists(file, ec)) {
+            sendHttpResponse(fd, 404, "");
+            return;
+        }
+        bool directory = fs::is_directory(file, ec);
+        std::string properties = directory ? "<D:resourcetype><D:collection/></D:resourcetype>"
+                                           : "<D:resourcetype/><D:getcontentlength>" + std::to_string(fs::file_size(file, ec)) +
+                                                 "</D:getcontentlength>";
+        sendHttpResponse(fd, 207,
+                         "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<D:multistatus xmlns:D=\"DAV:\"><D:response><D:href>" +
+                             request.path + "</D:href><D:propstat><D:prop>" + properties +
+                             "</D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response></D:multistatus>\n",
+                         true, "application/xml; charset=utf-8");
+    } else {
+        sendHttpResponse(fd, 405, "");
+    }
+}
+
+void serveCacheConnection(int fd, fs::path root) {
+    timeval timeout{30, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string buffer;
+    HttpRequest request;
+    while (!cacheServerStopping && readHttpRequest(fd, buffer, request)) {
+        if (request.rejected) {
+            sendHttpResponse(fd, request.rejected, "");
+            break;
+        }
+        serveCacheRequest(fd, root, request);
+        auto connection = request.headers.find("connection");
+        bool keepAlive = request.version == "HTTP/1.1" ? connection == request.headers.end() || connection->second != "close"
+                                                       : connection != request.headers.end() && connection->second == "keep-alive";
+        if (!keepAlive)
+            break;
+    }
+    close(fd);
+    --cacheServerConnections;
+}
+
+// The docker0 bridge address, which is what host-gateway resolves to inside `docker build`; loopback
+// when there is no bridge. Anything wider exposes unauthenticated PUT/DELETE to the network.
+std::string defaultCacheServerAddress() {
+    std::string address = "127.0.0.1";
+    ifaddrs *interfaces = nullptr;
+    if (getifaddrs(&interfaces) != 0)
+        return address;
+    for (ifaddrs *it = interfaces; it; it = it->ifa_next) {
+        if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET || std::strcmp(it->ifa_name, "docker0") != 0)
+            continue;
+        char text[INET_ADDRSTRLEN];
+        if (inet_ntop(AF_INET, &reinterpret_cast<sockaddr_in *>(it->ifa_addr)->sin_addr, text, sizeof(text)))
+            address = text;
+        break;
+    }
+    freeifaddrs(interfaces);
+    return address;
+}
+
+bool runCacheServer(const std::string &directory) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (!fs::is_directory(directory)) {
+        std::cerr << "캐시 디렉터리를 만들 수 없습니다: " << directory << "\n";
+        return false;
+    }
+    std::string bindAddress = operatorOptions.cacheServerBind.empty() ? defaultCacheServerAddress() : operatorOptions.cacheServerBind;
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    if (inet_pton(AF_INET, bindAddress.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "잘못된 --bind 주소입니다: " << bindAddress << "\n";
+        return false;
+    }
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    address.sin_port = htons(static_cast<uint16_t>(operatorOptions.cacheServerPort));
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 128) != 0) {
+        std::cerr << "포트 " << operatorOptions.cacheServerPort << "에서 대기할 수 없습니다: " << std::strerror(errno) << "\n";
+        if (listener >= 0)
+            close(listener);
+        return false;
+    }
+    std::signal(SIGINT, stopCacheServer);
+    std::signal(SIGTERM, stopCacheServer);
+    std::cerr << "컴파일 캐시 서버: http://" << bindAddress << ":" << operatorOptions.cacheServerPort << " -> " << directory << "\n";
+    if (bindAddress != "127.0.0.1" && bindAddress != defaultCacheServerAddress())
+        std::cerr << "  [경고] 인증 없이 PUT/DELETE를 받습니다. 이 주소에 접근할 수 있는 누구나 릴리스 바이너리에 링크될 캐시 객체를 바꿀 수 있습니다.\n";
+    std::cerr << "  (빌드에서는 --compile-cache=http://host.docker.internal:" << operatorOptions.cacheServerPort
+              << " 와 docker build --add-host=host.docker.internal:host-gateway)\n";
     
-    std::cout << "Dockerfile이 생성되었습니다: " << dockerfilePath.string() << "\n";
-    std::cout << "\nOperator 프로세스가 완료되었습니다. 해당 프로젝트는 Docker 컨테이너에서 실행될 준비가 되었습니다!\n";
+    fs::path root = fs::absolute(directory);
+    auto metricsWritten = std::chrono::steady_clock::now();
+    while (!cacheServerStopping) {
+        if (!operatorOptions.metricsPath.empty() && std::chrono::steady_clock::now() - metricsWritten > std::chrono::seconds(15)) {
+            writeMetricsFile(operatorOptions.metricsPath);
+            metricsWritten = std::chrono::steady_clock::now();
+        }
+        if (cacheServerConnections >= maxCacheConnections) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        pollfd waiting{listener, POLLIN, 0};
+        if (poll(&waiting, 1, 500) <= 0)
+            continue;
+        int client = accept(listener, nullptr, nullptr);
+        if (client >= 0) {
+            ++cacheServerConnections;
+            std::thread(serveCacheConnection, client, root).detach();
+        }
+    }
+    close(listener);
+    uint64_t hits = operatorMetrics.compileCacheHits.value(), misses = operatorMetrics.compileCacheMisses.value();
+    uint64_t lookups = hits + misses;
+    std::cerr << "\n요청 " << lookups << "건: 적중 " << hits << ", 누락 " << misses << " (적중률 "
+              << (lookups ? hits * 100 / lookups : 0) << "%), 저장 " << operatorMetrics.compileCacheStores.value() << "건 "
+              << operatorMetrics.compileCacheStoredBytes.value() / 1024 << " KiB\n";
+    return true;
+}
+
+void makeDockerfileOperation() {
+    makeDockerfile(promptFolderPath());
+}
+
+void vendorCacheOperation() {
+    prepareVendorCache(promptFolderPath());
 }
 
-int main() {
+void printUsage() {
+    std::cout << "usage: operator [options] [command <folder>]\n";
+    std::cout << "  make <folder>      make a dockerfile\n";
+    std::cout << "  vendor <folder>    prepare the offline build cache from lockfiles\n";
+    std::cout << "  context <folder>   write a reproducible build context tar (operator context . | docker build -)\n";
+    std::cout << "  fingerprint <folder>  print a content fingerprint of everything the image build depends on\n";
+    std::cout << "  estimate <folder>  estimate image size and build time of the generated Dockerfile and its variants (JSON)\n";
+    std::cout << "  optimize <Dockerfile> rewrite an existing Dockerfile for faster builds and smaller images\n";
+    std::cout << "  export <folder>... write languages, dependencies, base images and timings of many projects (columnar, --output)\n";
+    std::cout << "  query <file> [<column> [<column>=<value>]] print an export, or count the values of one column\n";
+    std::cout << "  cache-server <dir> serve a local ccache/sccache store over HTTP/WebDAV (--port=<n>, default 8080;\n";
+    std::cout << "                     --bind=<addr>, default the docker0 bridge or 127.0.0.1)\n";
+    std::cout << "  config             print the effective threads, memory limit and buffer sizes (cgroup-aware)\n";
+    std::cout << "  languages          list supported languages and validate language definition files\n";
+    std::cout << "options:\n";
+    std::cout << "  --offline          install from the vendored cache with no network during docker build\n";
+    std::cout << "  --output=<path>    context/optimize/estimate/export output file, '-' for stdout (default)\n";
+    std::cout << "  --compress=<alg>   context compression: gzip (default), zstd, none\n";
+    std::cout << "  --platforms=<list> cross-compile for e.g. linux/amd64,linux/arm64 and write docker-bake.hcl\n";
+    std::cout << "  --pgo=<command>    C++/Rust: profile-guided + LTO build, training runs $PGO_BINARY\n";
+    std::cout << "  --native-image[=<command>] Java: GraalVM native executable on distroless, tracing agent runs $AGENT_JAVA\n";
+    std::cout << "  --node-startup=<list> Node.js: compile-cache, bundle (esbuild), snapshot (V8 startup snapshot)\n";
+    std::cout << "  --compile-cache=<local|url> C++/Rust: ccache/sccache in the builder, local cache mount or a shared HTTP server\n";
+    std::cout << "  --events=<path>    write NDJSON progress events (scan, languages, dependencies, phase timings, files)\n";
+    std::cout << "  --background       idle I/O priority, nice 19, --read-limit=64M and --max-open-files=4 unless given\n";
+    std::cout << "  --read-limit=<n>   cap project file reads at n bytes/s (K, M, G suffixes; 0 = no cap)\n";
+    std::cout << "  --max-open-files=<n> read at most n project files at once (0 = no limit)\n";
+    std::cout << "  --metrics=<path>   write Prometheus metrics (textfile collector format) when the command ends\n";
+    std::cout << "  --org=<name>       prefer templates from templates/<name> (default: $OPERATOR_ORG)\n";
+    std::cout << "  --threads=<n>      compression and hashing threads (default: CPUs granted by cpuset and cgroup quota)\n";
+    std::cout << "  --memory-limit=<n> size buffers for this much memory instead of the cgroup limit (0 = unlimited)\n";
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> args;
+    if (const char *org = std::getenv("OPERATOR_ORG"))
+        operatorOptions.org = org;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--offline") {
+            operatorOptions.offline = true;
+        } else if (arg.rfind("--output=", 0) == 0) {
+            operatorOptions.output = arg.substr(9);
+        } else if (arg.rfind("--compress=", 0) == 0) {
+            operatorOptions.compression = arg.substr(11);
+        } else if (arg.rfind("--platforms=", 0) == 0) {
+            std::istringstream list(arg.substr(12));
+            std::string platform;
+            while (std::getline(list, platform, ','))
+                if (!trim(platform).empty())
+                    operatorOptions.platforms.push_back(trim(platform));
+        } else if (arg.rfind("--pgo=", 0) == 0) {
+            operatorOptions.pgoTraining = arg.substr(6);
+        } else if (arg.rfind("--compile-cache=", 0) == 0) {
+            operatorOptions.compileCache = arg.substr(16);
+        } else if (arg.rfind("--bind=", 0) == 0) {
+            operatorOptions.cacheServerBind = arg.substr(7);
+        } else if (arg.rfind("--port=", 0) == 0) {
+            uint64_t port = 0;
+            if (!parseCount(arg.substr(7), 65535, port) || port == 0) {
+                std::cerr << "잘못된 --port 값입니다: " << arg.substr(7) << "\n";
+                return 1;
+            }
+            operatorOptions.cacheServerPort = static_cast<int>(port);
+        } else if (arg == "--native-image" || arg.rfind("--native-image=", 0) == 0) {
+            operatorOptions.nativeImage = true;
+            operatorOptions.nativeImageTraining = arg.size() > 15 ? arg.substr(15) : "";
+        } else if (arg.rfind("--node-startup=", 0) == 0) {
+            std::istringstream list(arg.substr(15));
+            for (std::string option; std::getline(list, option, ',');) {
+                if (option != "compile-cache" && option != "bundle" && option != "snapshot") {
+                    std::cerr << "알 수 없는 --node-startup 항목입니다: " << option << "\n";
+                    return 1;
+                }
+                operatorOptions.nodeStartup.insert(option);
+            }
+        } else if (arg == "--background") {
+            operatorOptions.background = true;
+        } else if (arg.rfind("--read-limit=", 0) == 0) {
+            if (!parseByteSize(arg.substr(13), operatorOptions.readLimit)) {
+                std::cerr << "잘못된 --read-limit 값입니다: " << arg.substr(13) << "\n";
+                return 1;
+            }
+            operatorOptions.readLimitSet = true;
+        } else if (arg.rfind("--max-open-files=", 0) == 0) {
+            uint64_t files = 0;
+            if (!parseCount(arg.substr(17), std::numeric_limits<unsigned>::max(), files)) {
+                std::cerr << "잘못된 --max-open-files 값입니다: " << arg.substr(17) << "\n";
+                return 1;
+            }
+            operatorOptions.maxOpenFiles = static_cast<unsigned>(files);
+            operatorOptions.maxOpenFilesSet = true;
+        } else if (arg.rfind("--memory-limit=", 0) == 0) {
+            if (!parseByteSize(arg.substr(15), operatorOptions.memoryLimit)) {
+                std::cerr << "잘못된 --memory-limit 값입니다: " << arg.substr(15) << "\n";
+                return 1;
+            }
+            operatorOptions.memoryLimitSet = true;
+        } else if (arg.rfind("--metrics=", 0) == 0) {
+            operatorOptions.metricsPath = arg.substr(10);
+        } else if (arg.rfind("--events=", 0) == 0) {
+            if (!operatorOptions.eventsPath.empty()) {
+                std::cerr << "--events는 한 번만 지정할 수 있습니다.\n";
+                return 1;
+            }
+            operatorOptions.eventsPath = arg.substr(9);
+        } else if (arg.rfind("--org=", 0) == 0) {
+            operatorOptions.org = arg.substr(6);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            uint64_t threads = 0;
+            if (!parseCount(arg.substr(10), std::numeric_limits<unsigned>::max(), threads)) {
+                std::cerr << "잘못된 --threads 값입니다: " << arg.substr(10) << "\n";
+                return 1;
+            }
+            operatorOptions.threads = static_cast<unsigned>(threads);
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "알 수 없는 옵션입니다: " << arg << "\n";
+            printUsage();
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    
+    if (operatorOptions.background) {
+        if (!lowerProcessPriority())
+            std::cerr << "I/O 및 CPU 우선순위를 모두 낮추지는 못했습니다 (계속 진행합니다).\n";
+        if (!operatorOptions.readLimitSet)
+            operatorOptions.readLimit = 64ull << 20;
+        if (!operatorOptions.maxOpenFilesSet)
+            operatorOptions.maxOpenFiles = 4;
+    }
+    readThrottle.setRate(operatorOptions.readLimit);
+    openFileLimit.setLimit(operatorOptions.maxOpenFiles);
+    // Its writer thread is the first thread, started once the priority above is in place to inherit.
+    if (!operatorOptions.eventsPath.empty() && !eventStream.open(operatorOptions.eventsPath)) {
+        std::cerr << "이벤트 출력 파일을 열지 못했습니다: " << operatorOptions.eventsPath << "\n";
+        return 1;
+    }
+    if (eventStream.enabled()) {
+        const EffectiveConfig &config = effectiveConfig();
+        eventStream.emit("configuration", {{"threads", std::to_string(config.threads)},
+                                           {"threads_from", jsonString(config.threadsFrom)},
+                                           {"memory_limit", std::to_string(config.memoryLimit)},
+                                           {"gzip_chunks_in_flight", std::to_string(config.gzipChunksInFlight)},
+                                           {"read_buffer", std::to_string(config.readBufferSize)}});
+    }
+    
+    // Written on every return below, after the command has run.
+    struct MetricsOnExit {
+        ~MetricsOnExit() {
+            if (!operatorOptions.metricsPath.empty())
+                writeMetricsFile(operatorOptions.metricsPath);
+        }
+    } metricsOnExit;
+    
+    if (args.size() == 1 && args[0] == "config") {
+        printEffectiveConfig();
+        return 0;
+    }
+    if (args.size() == 1 && args[0] == "languages") {
+        listLanguages();
+        return loadLanguageDefinitions().errors.empty() && loadPlugins().errors.empty() ? 0 : 1;
+    }
+    if (args.size() == 2 && args[0] == "optimize")
+        return optimizeExistingDockerfile(args[1]) ? 0 : 1;
+    if (args.size() == 2 && args[0] == "cache-server")
+        return runCacheServer(args[1]) ? 0 : 1;
+    if (args.size() >= 2 && args[0] == "export")
+        return exportFleet(std::vector<std::string>(args.begin() + 1, args.end())) ? 0 : 1;
+    if (args.size() >= 2 && args.size() <= 4 && args[0] == "query")
+        return queryColumnar(args[1], args.size() > 2 ? args[2] : "", args.size() > 3 ? args[3] : "") ? 0 : 1;
+    if (!args.empty()) {
+        const std::string &command = args[0];
+        if (args.size() != 2 || !fs::is_directory(args[1])) {
+            std::cerr << "유효한 프로젝트 폴더를 지정하세요.\n";
+            printUsage();
+            return 1;
+        }
+        if (command == "make") {
+            makeDockerfile(args[1]);
+        } else if (command == "vendor") {
+            prepareVendorCache(args[1]);
+        } else if (command == "context") {
+            return writeBuildContext(args[1], operatorOptions.output, operatorOptions.compression) ? 0 : 1;
+        } else if (command == "estimate") {
+            return estimateProject(args[1]) ? 0 : 1;
+        } else if (command == "fingerprint") {
+            Hash128 fingerprint;
+            if (!computeFingerprint(args[1], fingerprint))
+                return 1;
+            std::cout << fingerprint.hex() << "\n";
+        } else {
+            std::cerr << "잘못된 명령입니다: " << command << "\n";
+            printUsage();
+            return 1;
+        }
+        return 0;
+    }
+    
     displayBanner();
-    initializeLanguageListFile();
     
     std::cout << "1 - make a dockerfile\n";
     std::cout << "2 - add a new language\n";
+    std::cout << "3 - prepare offline build cache\n";
     std::cout << "선택: ";
     
     int option = 0;
@@ -562,6 +7292,9 @@ int main() {
         case 2:
             addNewLanguage();
             break;
+        case 3:
+            vendorCacheOperation();
+            break;
         default:
             std::cerr << "잘못된 선택입니다.\n";
             break;
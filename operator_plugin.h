@@ -0,0 +1,76 @@
+#ifndef OPERATOR_PLUGIN_H
+#define OPERATOR_PLUGIN_H
+
+/*
+ * Operator handler plugin ABI.
+ *
+ * A plugin is a shared object exporting operator_plugin_entry(). Operator loads every *.so found in
+ * ./plugins, ~/.config/operator/plugins and OPERATOR_PLUGIN_PATH, and calls its hooks against the
+ * project index it already built: plugins query files by extension and read file buffers that are
+ * loaded once and shared with the built-in handlers, so they never walk the tree themselves.
+ *
+ * OPERATOR_PLUGIN_ABI_VERSION changes whenever an existing field changes meaning; a plugin built
+ * against another version is rejected. New fields are only ever appended, and struct_size tells
+ * either side how much of the other's struct it may read.
+ *
+ *     static int detect(const operator_host_api *host, const operator_project *project) {
+ *         return host->file_exists(project, "build.zig") || host->file_count(project, ".zig") > 0;
+ *     }
+ *     ...
+ *     static const operator_plugin plugin = {OPERATOR_PLUGIN_ABI_VERSION, sizeof(operator_plugin),
+ *                                            "Zig", detect, extract, render};
+ *     OPERATOR_PLUGIN_EXPORT const operator_plugin *operator_plugin_entry(uint32_t host_abi_version) {
+ *         return host_abi_version == OPERATOR_PLUGIN_ABI_VERSION ? &plugin : 0;
+ *     }
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPERATOR_PLUGIN_ABI_VERSION 1u
+
+#if defined(_WIN32)
+#define OPERATOR_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define OPERATOR_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef struct operator_project operator_project;
+
+/* Receives dependencies from extract() and Dockerfile text from render(). Strings are copied. */
+typedef struct operator_sink {
+    void (*emit)(struct operator_sink *sink, const char *text);
+} operator_sink;
+
+/* Everything returned by the host stays valid until the hook returns. Paths are relative to the project root. */
+typedef struct operator_host_api {
+    uint32_t abi_version;
+    uint32_t struct_size;
+    const char *(*root)(const operator_project *project);
+    int (*file_exists)(const operator_project *project, const char *relative_path);
+    size_t (*file_count)(const operator_project *project, const char *extension);
+    const char *(*file_path)(const operator_project *project, const char *extension, size_t index);
+    const char *(*file_contents)(const operator_project *project, const char *relative_path, size_t *size);
+} operator_host_api;
+
+typedef struct operator_plugin {
+    uint32_t abi_version;
+    uint32_t struct_size;
+    const char *name;
+    int (*detect)(const operator_host_api *host, const operator_project *project);
+    void (*extract)(const operator_host_api *host, const operator_project *project, operator_sink *deps);
+    void (*render)(const operator_host_api *host, const operator_project *project,
+                   const char *const *deps, size_t dep_count, operator_sink *out);
+} operator_plugin;
+
+typedef const operator_plugin *(*operator_plugin_entry_fn)(uint32_t host_abi_version);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif